@@ -68,12 +68,17 @@ public:
     }
 
     bool intersects(const BoxCollider& other) const {
-        return !(max.x < other.min.x || min.x > other.max.x ||
-                 max.y < other.min.y || min.y > other.max.y ||
-                 max.z < other.min.z || min.z > other.max.z);
+        return overlaps(min, max, other.min, other.max);
     }
 
-    void render(Shader shader, int mode = GL_LINE) {
+    static bool overlaps(const glm::vec3& aMin, const glm::vec3& aMax,
+                         const glm::vec3& bMin, const glm::vec3& bMax) {
+        return !(aMax.x < bMin.x || aMin.x > bMax.x ||
+                 aMax.y < bMin.y || aMin.y > bMax.y ||
+                 aMax.z < bMin.z || aMin.z > bMax.z);
+    }
+
+    void render(Shader& shader, int mode = GL_LINE) {
         boundingBox->render(shader, GL_LINE);
     }
 
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#ifndef BVH_LEAF_SIZE
+    #define BVH_LEAF_SIZE 4
+#endif
+
+#define BVH_STACK_SIZE 64
+
+// 32-byte node: an interior node (count == 0) has children leftFirst and
+// leftFirst + 1; a leaf covers primitives [leftFirst, leftFirst + count) of
+// Bvh::order.
+struct BvhNode {
+    glm::vec3 min;
+    uint32_t leftFirst;
+    glm::vec3 max;
+    uint32_t count;
+};
+
+// Bounding volume hierarchy over a set of primitive AABBs. It only knows
+// bounds, so the same class serves as a per-mesh triangle tree and as a tree
+// over instance bounds. Built top-down by splitting at the centroid median
+// of the widest axis, which keeps the depth at most log2(count) + 1 and so
+// lets traversal use a fixed-size stack.
+class Bvh {
+public:
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> order;
+
+    void build(const std::vector<glm::vec3>& primMin, const std::vector<glm::vec3>& primMax) {
+        size_t count = primMin.size();
+        nodes.clear();
+        order.resize(count);
+        for (size_t i = 0; i < count; ++i) order[i] = uint32_t(i);
+        if (count == 0) return;
+
+        centroids.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            centroids[i] = 0.5f * (primMin[i] + primMax[i]);
+
+        nodes.reserve(2 * count);
+        nodes.push_back({glm::vec3(0.0f), 0, glm::vec3(0.0f), uint32_t(count)});
+        subdivide(0, primMin, primMax);
+        centroids.clear();
+        centroids.shrink_to_fit();
+    }
+
+    bool empty() const { return nodes.empty(); }
+
+    // Calls fn(primitive) for every primitive whose bounds overlap the box;
+    // fn returns false to stop early. Returns false if it was stopped.
+    template <typename F>
+    bool forEachOverlap(const glm::vec3& boxMin, const glm::vec3& boxMax, F&& fn) const {
+        if (nodes.empty()) return true;
+        uint32_t stack[BVH_STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = nodes[stack[--top]];
+            if (!overlaps(node.min, node.max, boxMin, boxMax)) continue;
+            if (node.count > 0) {
+                for (uint32_t k = 0; k < node.count; ++k)
+                    if (!fn(order[node.leftFirst + k])) return false;
+            } else {
+                stack[top++] = node.leftFirst;
+                stack[top++] = node.leftFirst + 1;
+            }
+        }
+        return true;
+    }
+
+    // Visits primitives whose bounds the ray enters before `maxDistance`,
+    // nearer child first. fn(primitive, maxDistance) may shorten maxDistance
+    // to cull everything behind a hit.
+    template <typename F>
+    void forEachRayHit(const glm::vec3& origin, const glm::vec3& direction, float& maxDistance, F&& fn) const {
+        if (nodes.empty()) return;
+        glm::vec3 invDir = 1.0f / direction;
+        uint32_t stack[BVH_STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = nodes[stack[--top]];
+            if (rayEntry(node, origin, invDir, maxDistance) > maxDistance) continue;
+            if (node.count > 0) {
+                for (uint32_t k = 0; k < node.count; ++k)
+                    fn(order[node.leftFirst + k], maxDistance);
+                continue;
+            }
+            uint32_t near = node.leftFirst, far = node.leftFirst + 1;
+            if (rayEntry(nodes[near], origin, invDir, maxDistance) > rayEntry(nodes[far], origin, invDir, maxDistance))
+                std::swap(near, far);
+            stack[top++] = far;
+            stack[top++] = near;
+        }
+    }
+
+    static bool overlaps(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax) {
+        return !(aMax.x < bMin.x || aMin.x > bMax.x ||
+                 aMax.y < bMin.y || aMin.y > bMax.y ||
+                 aMax.z < bMin.z || aMin.z > bMax.z);
+    }
+
+    // Slab test; distance at which the ray enters the box, or a value past
+    // maxDistance if it misses.
+    static float rayEntry(const BvhNode& node, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance) {
+        glm::vec3 t0 = (node.min - origin) * invDir;
+        glm::vec3 t1 = (node.max - origin) * invDir;
+        glm::vec3 lo = glm::min(t0, t1), hi = glm::max(t0, t1);
+        float enter = std::max(std::max(lo.x, lo.y), std::max(lo.z, 0.0f));
+        float exit = std::min(std::min(hi.x, hi.y), hi.z);
+        return enter <= exit ? enter : maxDistance * 2.0f + 1.0f;
+    }
+
+private:
+    std::vector<glm::vec3> centroids;
+
+    void subdivide(uint32_t index, const std::vector<glm::vec3>& primMin, const std::vector<glm::vec3>& primMax) {
+        uint32_t first = nodes[index].leftFirst, count = nodes[index].count;
+
+        glm::vec3 lo(1e30f), hi(-1e30f), cLo(1e30f), cHi(-1e30f);
+        for (uint32_t k = first; k < first + count; ++k) {
+            uint32_t p = order[k];
+            lo = glm::min(lo, primMin[p]);
+            hi = glm::max(hi, primMax[p]);
+            cLo = glm::min(cLo, centroids[p]);
+            cHi = glm::max(cHi, centroids[p]);
+        }
+        nodes[index].min = lo;
+        nodes[index].max = hi;
+
+        if (count <= BVH_LEAF_SIZE) return;
+
+        glm::vec3 extent = cHi - cLo;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        if (extent[axis] <= 0.0f) return;
+
+        uint32_t half = count / 2;
+        std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                         [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+        uint32_t left = uint32_t(nodes.size());
+        nodes.push_back({glm::vec3(0.0f), first, glm::vec3(0.0f), half});
+        nodes.push_back({glm::vec3(0.0f), first + half, glm::vec3(0.0f), count - half});
+        nodes[index].leftFirst = left;
+        nodes[index].count = 0;
+
+        subdivide(left, primMin, primMax);
+        subdivide(left + 1, primMin, primMax);
+    }
+};
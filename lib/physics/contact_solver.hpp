@@ -0,0 +1,268 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+struct ContactConfig {
+    int iterations = 8;
+    float restitution = 0.2f;
+    float friction = 0.5f;
+    float baumgarte = 0.2f;     // fraction of penetration removed per step
+    float slop = 0.5f;          // penetration left alone, in world units
+    float bounceThreshold = 20.0f;  // closing speeds below this do not bounce
+};
+
+// Velocity state of one body as seen by the solver. Inverse inertia is a
+// world-space diagonal, matching how Drone applies torque / inertia; a body
+// with zero inverse mass and inertia is immovable.
+struct SolverBody {
+    glm::vec3 position;
+    float inverseMass;
+    glm::vec3 velocity;
+    glm::vec3 angularVelocity;
+    glm::vec3 inverseInertia;
+};
+
+#define CONTACT_STATIC -1
+
+// One contact point between body a and body b (or static geometry when b is
+// CONTACT_STATIC). The normal points from b towards a.
+struct Contact {
+    int a;
+    int b;
+    glm::vec3 point;
+    glm::vec3 normal;
+    float depth;
+
+    glm::vec3 ra, rb;
+    glm::vec3 tangent[2];
+    float normalMass;
+    float tangentMass[2];
+    float bias;
+    float normalImpulse;
+    float tangentImpulse[2];
+};
+
+struct ContactStats {
+    size_t contacts;
+    size_t islands;
+    size_t largestIsland;
+    double seconds;
+};
+
+// Sequential-impulse contact solver. Contacts are grouped into islands of
+// bodies connected through dynamic-dynamic contacts (union-find; static
+// geometry does not join islands), and because islands share no bodies
+// they are solved concurrently, each with the usual Gauss-Seidel sweeps:
+// accumulated normal impulses clamped to be non-negative, Coulomb friction
+// clamped to the current normal impulse, Baumgarte bias for penetration and
+// restitution above a closing speed threshold.
+class ContactSolver {
+public:
+    ContactConfig config;
+    std::vector<SolverBody> bodies;
+
+    explicit ContactSolver(const ContactConfig& _config = ContactConfig()) : config(_config), stats{0, 0, 0, 0.0} {}
+
+    const ContactStats& getStats() const { return stats; }
+    const std::vector<Contact>& getContacts() const { return contacts; }
+
+    void clear() { contacts.clear(); }
+
+    void addContact(int a, int b, const glm::vec3& point, const glm::vec3& normal, float depth) {
+        Contact c;
+        c.a = a;
+        c.b = b;
+        c.point = point;
+        c.normal = normal;
+        c.depth = depth;
+        contacts.push_back(c);
+    }
+
+    void addContacts(const std::vector<Contact>& more) {
+        contacts.insert(contacts.end(), more.begin(), more.end());
+    }
+
+    // Contact between two overlapping AABBs, pushing `a` out of `b`. The
+    // axis is the one of least penetration once `motion` (a's displacement
+    // relative to b over the last step) is taken off, i.e. the axis they
+    // were most likely separated along before it; plain least penetration
+    // picks the thin axis when two flat drones meet edge-on. Returns false
+    // if they do not overlap.
+    static bool boxContact(const glm::vec3& aMin, const glm::vec3& aMax,
+                           const glm::vec3& bMin, const glm::vec3& bMax, Contact& out,
+                           const glm::vec3& motion = glm::vec3(0.0f)) {
+        glm::vec3 lo = glm::max(aMin, bMin);
+        glm::vec3 hi = glm::min(aMax, bMax);
+        glm::vec3 overlap = hi - lo;
+        if (overlap.x <= 0.0f || overlap.y <= 0.0f || overlap.z <= 0.0f) return false;
+
+        glm::vec3 before = overlap - glm::abs(motion);
+        int axis = before.x < before.y ? (before.x < before.z ? 0 : 2) : (before.y < before.z ? 1 : 2);
+        float sign = (aMin[axis] + aMax[axis]) >= (bMin[axis] + bMax[axis]) ? 1.0f : -1.0f;
+
+        out.normal = glm::vec3(0.0f);
+        out.normal[axis] = sign;
+        out.depth = overlap[axis];
+        out.point = 0.5f * (lo + hi);
+        return true;
+    }
+
+    void solve(float deltaTime, ThreadPool* pool = nullptr) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        buildIslands();
+
+        auto range = [&](size_t begin, size_t end, unsigned int) {
+            for (size_t k = begin; k < end; ++k)
+                solveIsland(islandStart[k], islandStart[k + 1], deltaTime);
+        };
+
+        size_t islandCount = islandStart.empty() ? 0 : islandStart.size() - 1;
+        if (pool) pool->parallelFor(islandCount, range, 1);
+        else range(0, islandCount, 0);
+
+        stats.contacts = contacts.size();
+        stats.islands = islandCount;
+        stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - T0).count();
+    }
+
+private:
+    std::vector<Contact> contacts;
+    std::vector<Contact> sorted;
+    std::vector<int> parent;
+    std::vector<int> islandOf;
+    std::vector<size_t> islandStart;
+    ContactStats stats;
+
+    int find(int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // Buckets the contacts by island into `sorted`, largest island first so
+    // the long jobs start early, and records where each island begins.
+    void buildIslands() {
+        size_t n = bodies.size();
+        parent.resize(n);
+        for (size_t i = 0; i < n; ++i) parent[i] = int(i);
+
+        for (const Contact& c : contacts) {
+            if (c.b == CONTACT_STATIC) continue;
+            int ra = find(c.a), rb = find(c.b);
+            if (ra != rb) parent[ra] = rb;
+        }
+
+        // Island id per root, numbered in order of first appearance.
+        islandOf.assign(n, -1);
+        std::vector<size_t> counts;
+        for (const Contact& c : contacts) {
+            int root = find(c.a);
+            if (islandOf[root] < 0) {
+                islandOf[root] = int(counts.size());
+                counts.push_back(0);
+            }
+            ++counts[islandOf[root]];
+        }
+
+        std::vector<int> order(counts.size());
+        for (size_t k = 0; k < order.size(); ++k) order[k] = int(k);
+        std::sort(order.begin(), order.end(), [&](int x, int y) { return counts[x] > counts[y]; });
+
+        std::vector<size_t> offset(counts.size());
+        islandStart.assign(counts.size() + 1, 0);
+        for (size_t k = 0; k < order.size(); ++k) {
+            offset[order[k]] = islandStart[k];
+            islandStart[k + 1] = islandStart[k] + counts[order[k]];
+        }
+
+        sorted.resize(contacts.size());
+        for (const Contact& c : contacts)
+            sorted[offset[islandOf[find(c.a)]]++] = c;
+        contacts.swap(sorted);
+
+        stats.largestIsland = counts.empty() ? 0 : counts[order[0]];
+    }
+
+    SolverBody& body(int i, SolverBody& ground) { return i == CONTACT_STATIC ? ground : bodies[i]; }
+
+    static float effectiveMass(const SolverBody& A, const SolverBody& B, const glm::vec3& ra, const glm::vec3& rb, const glm::vec3& dir) {
+        glm::vec3 ca = glm::cross(ra, dir);
+        glm::vec3 cb = glm::cross(rb, dir);
+        float k = A.inverseMass + B.inverseMass + glm::dot(ca * A.inverseInertia, ca) + glm::dot(cb * B.inverseInertia, cb);
+        return k > 0.0f ? 1.0f / k : 0.0f;
+    }
+
+    static glm::vec3 relativeVelocity(const SolverBody& A, const SolverBody& B, const Contact& c) {
+        return A.velocity + glm::cross(A.angularVelocity, c.ra) - B.velocity - glm::cross(B.angularVelocity, c.rb);
+    }
+
+    static void applyImpulse(SolverBody& A, SolverBody& B, const Contact& c, const glm::vec3& impulse) {
+        A.velocity += impulse * A.inverseMass;
+        A.angularVelocity += glm::cross(c.ra, impulse) * A.inverseInertia;
+        B.velocity -= impulse * B.inverseMass;
+        B.angularVelocity -= glm::cross(c.rb, impulse) * B.inverseInertia;
+    }
+
+    void solveIsland(size_t begin, size_t end, float deltaTime) {
+        // Each island has its own immovable stand-in for static geometry, so
+        // concurrent islands never touch the same memory.
+        SolverBody ground = {glm::vec3(0.0f), 0.0f, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f)};
+
+        for (size_t k = begin; k < end; ++k) {
+            Contact& c = contacts[k];
+            SolverBody& A = body(c.a, ground);
+            SolverBody& B = body(c.b, ground);
+            c.ra = c.point - A.position;
+            c.rb = c.b == CONTACT_STATIC ? glm::vec3(0.0f) : c.point - B.position;
+
+            glm::vec3 axis = std::abs(c.normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            c.tangent[0] = glm::normalize(glm::cross(c.normal, axis));
+            c.tangent[1] = glm::cross(c.normal, c.tangent[0]);
+
+            c.normalMass = effectiveMass(A, B, c.ra, c.rb, c.normal);
+            c.tangentMass[0] = effectiveMass(A, B, c.ra, c.rb, c.tangent[0]);
+            c.tangentMass[1] = effectiveMass(A, B, c.ra, c.rb, c.tangent[1]);
+
+            float closing = glm::dot(relativeVelocity(A, B, c), c.normal);
+            float bounce = closing < -config.bounceThreshold ? -config.restitution * closing : 0.0f;
+            float push = config.baumgarte / deltaTime * std::max(c.depth - config.slop, 0.0f);
+            c.bias = std::max(bounce, push);
+
+            c.normalImpulse = 0.0f;
+            c.tangentImpulse[0] = 0.0f;
+            c.tangentImpulse[1] = 0.0f;
+        }
+
+        for (int it = 0; it < config.iterations; ++it) {
+            for (size_t k = begin; k < end; ++k) {
+                Contact& c = contacts[k];
+                SolverBody& A = body(c.a, ground);
+                SolverBody& B = body(c.b, ground);
+
+                glm::vec3 dv = relativeVelocity(A, B, c);
+                for (int t = 0; t < 2; ++t) {
+                    float lambda = -glm::dot(dv, c.tangent[t]) * c.tangentMass[t];
+                    float limit = config.friction * c.normalImpulse;
+                    float previous = c.tangentImpulse[t];
+                    c.tangentImpulse[t] = glm::clamp(previous + lambda, -limit, limit);
+                    applyImpulse(A, B, c, c.tangent[t] * (c.tangentImpulse[t] - previous));
+                }
+
+                dv = relativeVelocity(A, B, c);
+                float lambda = (c.bias - glm::dot(dv, c.normal)) * c.normalMass;
+                float previous = c.normalImpulse;
+                c.normalImpulse = std::max(previous + lambda, 0.0f);
+                applyImpulse(A, B, c, c.normal * (c.normalImpulse - previous));
+            }
+        }
+    }
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <utility>
+
+// Dense row-major matrix with compile-time dimensions. Storage is an inline
+// array, so temporaries live on the stack and no operation allocates.
+template <size_t R, size_t C>
+struct Matrix {
+    float m[R][C];
+
+    static Matrix zero() {
+        Matrix out;
+        for (size_t r = 0; r < R; ++r)
+            for (size_t c = 0; c < C; ++c)
+                out.m[r][c] = 0.0f;
+        return out;
+    }
+
+    static Matrix identity() {
+        Matrix out = zero();
+        for (size_t i = 0; i < (R < C ? R : C); ++i)
+            out.m[i][i] = 1.0f;
+        return out;
+    }
+
+    float& operator()(size_t r, size_t c) { return m[r][c]; }
+    float operator()(size_t r, size_t c) const { return m[r][c]; }
+
+    // Flat element access, mainly for vectors (R x 1 or 1 x C).
+    float& operator[](size_t i) { return (&m[0][0])[i]; }
+    float operator[](size_t i) const { return (&m[0][0])[i]; }
+
+    Matrix<C, R> transpose() const {
+        Matrix<C, R> out;
+        for (size_t r = 0; r < R; ++r)
+            for (size_t c = 0; c < C; ++c)
+                out.m[c][r] = m[r][c];
+        return out;
+    }
+
+    Matrix& operator+=(const Matrix& o) {
+        for (size_t r = 0; r < R; ++r)
+            for (size_t c = 0; c < C; ++c)
+                m[r][c] += o.m[r][c];
+        return *this;
+    }
+
+    Matrix& operator-=(const Matrix& o) {
+        for (size_t r = 0; r < R; ++r)
+            for (size_t c = 0; c < C; ++c)
+                m[r][c] -= o.m[r][c];
+        return *this;
+    }
+
+    Matrix& operator*=(float s) {
+        for (size_t r = 0; r < R; ++r)
+            for (size_t c = 0; c < C; ++c)
+                m[r][c] *= s;
+        return *this;
+    }
+
+    Matrix operator+(const Matrix& o) const { Matrix out = *this; out += o; return out; }
+    Matrix operator-(const Matrix& o) const { Matrix out = *this; out -= o; return out; }
+    Matrix operator*(float s) const { Matrix out = *this; out *= s; return out; }
+};
+
+template <size_t R, size_t K, size_t C>
+inline Matrix<R, C> operator*(const Matrix<R, K>& a, const Matrix<K, C>& b) {
+    Matrix<R, C> out = Matrix<R, C>::zero();
+    for (size_t r = 0; r < R; ++r)
+        for (size_t k = 0; k < K; ++k) {
+            float v = a.m[r][k];
+            for (size_t c = 0; c < C; ++c)
+                out.m[r][c] += v * b.m[k][c];
+        }
+    return out;
+}
+
+// Gauss-Jordan elimination with partial pivoting. Returns false and leaves
+// `out` unspecified when the matrix is singular.
+template <size_t N>
+inline bool invert(const Matrix<N, N>& a, Matrix<N, N>& out) {
+    Matrix<N, N> work = a;
+    out = Matrix<N, N>::identity();
+
+    for (size_t col = 0; col < N; ++col) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < N; ++r)
+            if (std::fabs(work.m[r][col]) > std::fabs(work.m[pivot][col]))
+                pivot = r;
+        if (std::fabs(work.m[pivot][col]) < 1e-12f)
+            return false;
+
+        if (pivot != col) {
+            for (size_t c = 0; c < N; ++c) {
+                std::swap(work.m[col][c], work.m[pivot][c]);
+                std::swap(out.m[col][c], out.m[pivot][c]);
+            }
+        }
+
+        float inv = 1.0f / work.m[col][col];
+        for (size_t c = 0; c < N; ++c) {
+            work.m[col][c] *= inv;
+            out.m[col][c] *= inv;
+        }
+
+        for (size_t r = 0; r < N; ++r) {
+            if (r == col) continue;
+            float f = work.m[r][col];
+            if (f == 0.0f) continue;
+            for (size_t c = 0; c < N; ++c) {
+                work.m[r][c] -= f * work.m[col][c];
+                out.m[r][c] -= f * out.m[col][c];
+            }
+        }
+    }
+    return true;
+}
+
+// LU factorisation with partial pivoting, in place: afterwards `a` holds L
+// (unit diagonal, below) and U (on and above), and row i of the factored
+// system is row pivots[i] of the original. Returns false if singular or
+// not finite.
+template <size_t N>
+inline bool luDecompose(Matrix<N, N>& a, size_t (&pivots)[N]) {
+    for (size_t i = 0; i < N; ++i) pivots[i] = i;
+
+    for (size_t col = 0; col < N; ++col) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < N; ++r)
+            if (std::fabs(a.m[r][col]) > std::fabs(a.m[pivot][col]))
+                pivot = r;
+        // Written so that a NaN pivot fails too; inf or NaN anywhere in the
+        // pivot row would spread into every later row and the solution.
+        if (!(std::fabs(a.m[pivot][col]) >= 1e-12f))
+            return false;
+        for (size_t c = col; c < N; ++c)
+            if (!std::isfinite(a.m[pivot][c])) return false;
+
+        if (pivot != col) {
+            for (size_t c = 0; c < N; ++c) std::swap(a.m[col][c], a.m[pivot][c]);
+            std::swap(pivots[col], pivots[pivot]);
+        }
+
+        float inv = 1.0f / a.m[col][col];
+        for (size_t r = col + 1; r < N; ++r) {
+            float f = a.m[r][col] * inv;
+            a.m[r][col] = f;
+            if (f == 0.0f) continue;
+            for (size_t c = col + 1; c < N; ++c)
+                a.m[r][c] -= f * a.m[col][c];
+        }
+    }
+    return true;
+}
+
+// Solves A x = b for every column of b, given luDecompose's output for A.
+template <size_t N, size_t C>
+inline void luSolve(const Matrix<N, N>& lu, const size_t (&pivots)[N], const Matrix<N, C>& b, Matrix<N, C>& x) {
+    for (size_t r = 0; r < N; ++r)
+        for (size_t c = 0; c < C; ++c)
+            x.m[r][c] = b.m[pivots[r]][c];
+
+    for (size_t r = 1; r < N; ++r)
+        for (size_t k = 0; k < r; ++k) {
+            float f = lu.m[r][k];
+            if (f == 0.0f) continue;
+            for (size_t c = 0; c < C; ++c)
+                x.m[r][c] -= f * x.m[k][c];
+        }
+
+    for (size_t r = N; r-- > 0;) {
+        for (size_t k = r + 1; k < N; ++k) {
+            float f = lu.m[r][k];
+            if (f == 0.0f) continue;
+            for (size_t c = 0; c < C; ++c)
+                x.m[r][c] -= f * x.m[k][c];
+        }
+        float inv = 1.0f / lu.m[r][r];
+        for (size_t c = 0; c < C; ++c)
+            x.m[r][c] *= inv;
+    }
+}
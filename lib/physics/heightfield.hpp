@@ -0,0 +1,204 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdint>
+#include <cctype>
+
+#include "mapped_file.hpp"
+#include "contact_solver.hpp"
+
+struct HeightSample {
+    float height;
+    glm::vec3 normal;
+};
+
+// Terrain as a regular grid of heights over the xz plane, sampled
+// bilinearly. Any point maps to its grid cell with one multiply, so height
+// and normal lookups are O(1) however large the terrain is; outside the
+// grid the edge heights extend outwards. With no grid loaded it is a flat
+// ground plane at `baseHeight`.
+//
+// World height = baseHeight + heightScale * stored value. Raw files hold
+// width * depth native-endian float32 values, row-major in z, and are used
+// in place from the mapping; 8- and 16-bit binary PGM (P5) files are
+// converted to floats in [0, 1] on load.
+class Heightfield {
+public:
+    glm::vec2 origin;       // world xz of sample (0, 0)
+    float cellSize;
+    float heightScale;
+    float baseHeight;
+
+    explicit Heightfield(float _baseHeight = 0.0f)
+        : origin(0.0f), cellSize(1.0f), heightScale(1.0f), baseHeight(_baseHeight),
+          width(0), depth(0), invCellSize(1.0f), heights(nullptr) {}
+
+    Heightfield(const Heightfield&) = delete;
+    Heightfield& operator=(const Heightfield&) = delete;
+
+    int getWidth() const { return width; }
+    int getDepth() const { return depth; }
+    bool isFlat() const { return heights == nullptr; }
+
+    bool loadRaw(const std::string& path, int _width, int _depth, float _cellSize, float _heightScale = 1.0f) {
+        if (_width < 2 || _depth < 2) {
+            std::cerr << "Error: Heightfield needs at least 2x2 samples: " << path << "\n";
+            return false;
+        }
+        // The current grid may live in `mapped`, so it is only replaced once
+        // the new file has been checked; on failure the old grid stays.
+        MappedFile file;
+        if (!file.open(path)) return false;
+        if (file.getSize() < size_t(_width) * _depth * sizeof(float)) {
+            std::cerr << "Error: Heightfield file is smaller than " << _width << "x" << _depth << " floats: " << path << "\n";
+            return false;
+        }
+        mapped.swap(file);
+        owned.clear();
+        setGrid(reinterpret_cast<const float*>(mapped.getData()), _width, _depth, _cellSize, _heightScale);
+        return true;
+    }
+
+    bool loadPgm(const std::string& path, float _cellSize, float _heightScale = 1.0f) {
+        MappedFile file;
+        if (!file.open(path)) return false;
+
+        const char* text = reinterpret_cast<const char*>(file.getData());
+        size_t size = file.getSize(), at = 0;
+        long fields[3] = {0, 0, 0};
+        bool ok = size > 2 && text[0] == 'P' && text[1] == '5';
+        at = 2;
+        for (int f = 0; ok && f < 3; ++f)
+            ok = readPgmField(text, size, at, fields[f]);
+        // Exactly one whitespace byte separates the header from the samples.
+        ++at;
+
+        int w = int(fields[0]), d = int(fields[1]);
+        long maxValue = fields[2];
+        size_t bytesPerSample = maxValue > 255 ? 2 : 1;
+        if (!ok || w < 2 || d < 2 || maxValue <= 0 || maxValue > 65535 ||
+            size < at + size_t(w) * d * bytesPerSample) {
+            std::cerr << "Error: Invalid or truncated PGM heightfield: " << path << "\n";
+            return false;
+        }
+
+        const uint8_t* samples = file.getData() + at;
+        float inverseMax = 1.0f / float(maxValue);
+        owned.resize(size_t(w) * d);
+        for (size_t k = 0; k < owned.size(); ++k) {
+            // 16-bit PGM samples are big-endian.
+            unsigned value = bytesPerSample == 2 ? (unsigned(samples[2 * k]) << 8) | samples[2 * k + 1] : samples[k];
+            owned[k] = float(value) * inverseMax;
+        }
+
+        mapped.close();
+        setGrid(owned.data(), w, d, _cellSize, _heightScale);
+        return true;
+    }
+
+    float heightAt(float x, float z) const {
+        if (!heights) return baseHeight;
+        Cell c = locate(x, z);
+        float lo = c.h00 + (c.h10 - c.h00) * c.fx;
+        float hi = c.h01 + (c.h11 - c.h01) * c.fx;
+        return baseHeight + heightScale * (lo + (hi - lo) * c.fz);
+    }
+
+    // Height and the normal of the bilinear surface at (x, z).
+    HeightSample sample(float x, float z) const {
+        if (!heights) return {baseHeight, glm::vec3(0.0f, 1.0f, 0.0f)};
+        Cell c = locate(x, z);
+        float lo = c.h00 + (c.h10 - c.h00) * c.fx;
+        float hi = c.h01 + (c.h11 - c.h01) * c.fx;
+        float slopeScale = heightScale * invCellSize;
+        float dx = ((c.h10 - c.h00) * (1.0f - c.fz) + (c.h11 - c.h01) * c.fz) * slopeScale * c.insideX;
+        float dz = (hi - lo) * slopeScale * c.insideZ;
+        return {baseHeight + heightScale * (lo + (hi - lo) * c.fz), glm::normalize(glm::vec3(-dx, 1.0f, -dz))};
+    }
+
+    // Contact for a box resting on or sunk into the terrain. The centre and
+    // corners of the bottom face are tested and the deepest one is used,
+    // with the surface normal there; depth is measured along that normal.
+    bool boxContact(const glm::vec3& boxMin, const glm::vec3& boxMax, Contact& out) const {
+        const float xs[5] = {0.5f * (boxMin.x + boxMax.x), boxMin.x, boxMax.x, boxMin.x, boxMax.x};
+        const float zs[5] = {0.5f * (boxMin.z + boxMax.z), boxMin.z, boxMin.z, boxMax.z, boxMax.z};
+
+        int deepest = 0;
+        float deepestHeight = heightAt(xs[0], zs[0]);
+        for (int k = 1; k < 5; ++k) {
+            float h = heightAt(xs[k], zs[k]);
+            if (h > deepestHeight) {
+                deepestHeight = h;
+                deepest = k;
+            }
+        }
+        if (deepestHeight <= boxMin.y) return false;
+
+        HeightSample s = sample(xs[deepest], zs[deepest]);
+        out.point = glm::vec3(xs[deepest], boxMin.y, zs[deepest]);
+        out.normal = s.normal;
+        out.depth = (s.height - boxMin.y) * s.normal.y;
+        return true;
+    }
+
+private:
+    int width;
+    int depth;
+    float invCellSize;
+    const float* heights;
+
+    std::vector<float> owned;
+    MappedFile mapped;
+
+    struct Cell {
+        float h00, h10, h01, h11;
+        float fx, fz;
+        float insideX, insideZ;     // 0 where the lookup was clamped to an edge
+    };
+
+    Cell locate(float x, float z) const {
+        float gx = (x - origin.x) * invCellSize;
+        float gz = (z - origin.y) * invCellSize;
+        float insideX = gx >= 0.0f && gx <= float(width - 1) ? 1.0f : 0.0f;
+        float insideZ = gz >= 0.0f && gz <= float(depth - 1) ? 1.0f : 0.0f;
+        gx = gx < 0.0f ? 0.0f : (gx > float(width - 1) ? float(width - 1) : gx);
+        gz = gz < 0.0f ? 0.0f : (gz > float(depth - 1) ? float(depth - 1) : gz);
+        int ix = int(gx), iz = int(gz);
+        ix = ix < width - 2 ? ix : width - 2;
+        iz = iz < depth - 2 ? iz : depth - 2;
+
+        const float* row = heights + size_t(iz) * width + ix;
+        return {row[0], row[1], row[width], row[width + 1], gx - float(ix), gz - float(iz), insideX, insideZ};
+    }
+
+    void setGrid(const float* data, int w, int d, float _cellSize, float _heightScale) {
+        heights = data;
+        width = w;
+        depth = d;
+        cellSize = _cellSize;
+        invCellSize = 1.0f / _cellSize;
+        heightScale = _heightScale;
+    }
+
+    // Next whitespace-separated integer in a PGM header, skipping comments.
+    static bool readPgmField(const char* text, size_t size, size_t& at, long& value) {
+        while (at < size) {
+            if (text[at] == '#') {
+                while (at < size && text[at] != '\n') ++at;
+            } else if (std::isspace(static_cast<unsigned char>(text[at]))) {
+                ++at;
+            } else {
+                break;
+            }
+        }
+        if (at >= size || !std::isdigit(static_cast<unsigned char>(text[at]))) return false;
+        value = 0;
+        while (at < size && std::isdigit(static_cast<unsigned char>(text[at])) && value < 1000000)
+            value = value * 10 + (text[at++] - '0');
+        return true;
+    }
+};
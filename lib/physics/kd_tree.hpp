@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#define KD_TREE_NONE 0xffffffffu
+
+// Incremental 3D k-d tree over points. Each insert descends to a leaf and
+// hangs the new point there, splitting on the axis after its parent's, so
+// no rebalancing is ever done; for points inserted in random order (as
+// sampling planners produce them) the expected depth is O(log n).
+class KdTree {
+public:
+    std::vector<glm::vec3> points;
+
+    void clear() {
+        points.clear();
+        left.clear();
+        right.clear();
+        axis.clear();
+    }
+
+    void reserve(size_t count) {
+        points.reserve(count);
+        left.reserve(count);
+        right.reserve(count);
+        axis.reserve(count);
+    }
+
+    size_t size() const { return points.size(); }
+
+    uint32_t insert(const glm::vec3& p) {
+        uint32_t index = uint32_t(points.size());
+        points.push_back(p);
+        left.push_back(KD_TREE_NONE);
+        right.push_back(KD_TREE_NONE);
+        if (index == 0) {
+            axis.push_back(0);
+            return index;
+        }
+
+        uint32_t node = 0;
+        while (true) {
+            int a = axis[node];
+            std::vector<uint32_t>& side = p[a] < points[node][a] ? left : right;
+            if (side[node] == KD_TREE_NONE) {
+                side[node] = index;
+                axis.push_back(uint8_t((a + 1) % 3));
+                return index;
+            }
+            node = side[node];
+        }
+    }
+
+    // Index of the closest point, or KD_TREE_NONE if the tree is empty.
+    uint32_t nearest(const glm::vec3& q) const {
+        uint32_t best = KD_TREE_NONE;
+        float bestDistSq = 3.4e38f;
+        if (!points.empty()) nearest(0, q, best, bestDistSq);
+        return best;
+    }
+
+    // Appends every point within `radius` of q to `out`.
+    void withinRadius(const glm::vec3& q, float radius, std::vector<uint32_t>& out) const {
+        if (!points.empty()) withinRadius(0, q, radius * radius, radius, out);
+    }
+
+private:
+    std::vector<uint32_t> left;
+    std::vector<uint32_t> right;
+    std::vector<uint8_t> axis;
+
+    void nearest(uint32_t node, const glm::vec3& q, uint32_t& best, float& bestDistSq) const {
+        glm::vec3 d = points[node] - q;
+        float distSq = glm::dot(d, d);
+        if (distSq < bestDistSq) {
+            bestDistSq = distSq;
+            best = node;
+        }
+        float split = q[axis[node]] - points[node][axis[node]];
+        uint32_t nearSide = split < 0.0f ? left[node] : right[node];
+        uint32_t farSide = split < 0.0f ? right[node] : left[node];
+        if (nearSide != KD_TREE_NONE) nearest(nearSide, q, best, bestDistSq);
+        if (farSide != KD_TREE_NONE && split * split < bestDistSq) nearest(farSide, q, best, bestDistSq);
+    }
+
+    void withinRadius(uint32_t node, const glm::vec3& q, float radiusSq, float radius, std::vector<uint32_t>& out) const {
+        glm::vec3 d = points[node] - q;
+        if (glm::dot(d, d) <= radiusSq) out.push_back(node);
+        float split = q[axis[node]] - points[node][axis[node]];
+        if (left[node] != KD_TREE_NONE && split < radius) withinRadius(left[node], q, radiusSq, radius, out);
+        if (right[node] != KD_TREE_NONE && split >= -radius) withinRadius(right[node], q, radiusSq, radius, out);
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Read-only view of a whole file. Memory-mapped where POSIX mmap exists, so
+// large baked assets are paged in on demand and shared between processes;
+// elsewhere the file is read into an owned buffer.
+class MappedFile {
+public:
+    MappedFile() : data(nullptr), size(0), mapped(false) {}
+
+    explicit MappedFile(const std::string& path) : MappedFile() { open(path); }
+
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open file: " << path << "\n";
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            std::cerr << "Error: Could not read size of file: " << path << "\n";
+            ::close(fd);
+            return false;
+        }
+        void* ptr = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (ptr == MAP_FAILED) {
+            std::cerr << "Error: mmap of '" << path << "' failed.\n";
+            return false;
+        }
+        data = static_cast<const uint8_t*>(ptr);
+        size = size_t(info.st_size);
+        mapped = true;
+        return true;
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file: " << path << "\n";
+            return false;
+        }
+        buffer.resize(size_t(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<uint8_t*>(data), size);
+#endif
+        buffer.clear();
+        data = nullptr;
+        size = 0;
+        mapped = false;
+    }
+
+    // Lets a caller open and validate a file before replacing a mapping
+    // that is still in use.
+    void swap(MappedFile& other) {
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(mapped, other.mapped);
+        buffer.swap(other.buffer);
+    }
+
+    const uint8_t* getData() const { return data; }
+    size_t getSize() const { return size; }
+    bool isOpen() const { return data != nullptr; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    bool mapped;
+    std::vector<uint8_t> buffer;
+};
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "world.hpp"
+#include "spatial_grid.hpp"
+
+#define OCCUPANCY_BRICK_SIZE 8
+#define OCCUPANCY_EMPTY_KEY ~uint64_t(0)
+
+// 8x8x8 voxels in 64 bytes: word z holds the z-th slice, bit y * 8 + x.
+struct OccupancyBrick {
+    uint64_t bits[OCCUPANCY_BRICK_SIZE];
+};
+
+struct OccupancyMemory {
+    size_t bricks;
+    size_t occupiedVoxels;
+    size_t bytes;
+    double bytesPerMillionOccupied;
+    double bytesPerMillionDense;    // the same volume as SpatialGrid cells
+};
+
+// Sparse boolean voxel grid for planning. Space is split into 8^3 bricks
+// stored as bitsets and found through an open-addressing hash of brick
+// coordinates, so empty space costs nothing and an occupied region costs
+// one bit per voxel plus ~12 bytes of table per brick, against a
+// GridCell (a std::vector) per cell for a dense SpatialGrid.
+//
+// Voxel v covers [origin + v * voxelSize, origin + (v + 1) * voxelSize).
+// Coordinates are limited to +-2^20 voxels per axis.
+class OccupancyMap {
+public:
+    float voxelSize;
+    glm::vec3 origin;
+
+    explicit OccupancyMap(float _voxelSize, const glm::vec3& _origin = glm::vec3(0.0f))
+        : voxelSize(_voxelSize), origin(_origin), occupied(0) {
+        resizeTable(64);
+    }
+
+    glm::ivec3 toVoxel(const glm::vec3& pos) const {
+        return glm::ivec3(glm::floor((pos - origin) / voxelSize));
+    }
+
+    glm::vec3 voxelCenter(const glm::ivec3& v) const {
+        return origin + (glm::vec3(v) + 0.5f) * voxelSize;
+    }
+
+    void clear() {
+        bricks.clear();
+        std::fill(keys.begin(), keys.end(), OCCUPANCY_EMPTY_KEY);
+        occupied = 0;
+    }
+
+    bool isOccupied(const glm::ivec3& v) const {
+        const OccupancyBrick* brick = findBrick(brickOf(v));
+        return brick && testBit(*brick, v);
+    }
+
+    bool isOccupied(const glm::vec3& pos) const { return isOccupied(toVoxel(pos)); }
+
+    void set(const glm::ivec3& v) {
+        OccupancyBrick& brick = getOrAddBrick(brickOf(v));
+        glm::ivec3 l = v & (OCCUPANCY_BRICK_SIZE - 1);
+        uint64_t mask = uint64_t(1) << (l.y * OCCUPANCY_BRICK_SIZE + l.x);
+        occupied += (brick.bits[l.z] & mask) ? 0 : 1;
+        brick.bits[l.z] |= mask;
+    }
+
+    // Marks every voxel overlapping the box.
+    void rasterizeBox(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        glm::ivec3 lo = toVoxel(boxMin), hi = toVoxel(boxMax);
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                    set({x, y, z});
+    }
+
+    // Marks every voxel a world triangle passes through, with an exact
+    // triangle/box test per brick and then per voxel inside the bricks that
+    // pass. `inflate` grows the voxels for the test, to leave a safety
+    // margin around the geometry.
+    void rasterize(const World& world, float inflate = 0.0f) {
+        const glm::vec3 pad(inflate);
+        const float brickSize = voxelSize * OCCUPANCY_BRICK_SIZE;
+        for (const WorldInstance& instance : world.instances) {
+            const CollisionMesh& mesh = world.assets[instance.asset];
+            for (size_t t = 0; t < mesh.triangleCount(); ++t) {
+                glm::vec3 v[3];
+                for (int k = 0; k < 3; ++k)
+                    v[k] = glm::vec3(instance.model * glm::vec4(mesh.positions[mesh.indices[3 * t + k]], 1.0f));
+
+                glm::ivec3 lo = toVoxel(glm::min(glm::min(v[0], v[1]), v[2]) - pad);
+                glm::ivec3 hi = toVoxel(glm::max(glm::max(v[0], v[1]), v[2]) + pad);
+                glm::ivec3 bLo = brickOf(lo), bHi = brickOf(hi);
+
+                for (int bz = bLo.z; bz <= bHi.z; ++bz)
+                    for (int by = bLo.y; by <= bHi.y; ++by)
+                        for (int bx = bLo.x; bx <= bHi.x; ++bx) {
+                            glm::ivec3 base = glm::ivec3(bx, by, bz) * OCCUPANCY_BRICK_SIZE;
+                            glm::vec3 brickMin = origin + glm::vec3(base) * voxelSize;
+                            if (!World::triangleOverlapsBox(v, brickMin - pad, brickMin + brickSize + pad)) continue;
+                            rasterizeInBrick(v, pad, base, glm::max(lo, base), glm::min(hi, base + (OCCUPANCY_BRICK_SIZE - 1)));
+                        }
+            }
+        }
+    }
+
+    // True if any voxel in the inclusive box [lo, hi] is occupied. Whole
+    // 8x8 slices are tested as one masked word.
+    bool anyOccupied(const glm::ivec3& lo, const glm::ivec3& hi) const {
+        glm::ivec3 bLo = brickOf(lo), bHi = brickOf(hi);
+        for (int bz = bLo.z; bz <= bHi.z; ++bz)
+            for (int by = bLo.y; by <= bHi.y; ++by)
+                for (int bx = bLo.x; bx <= bHi.x; ++bx) {
+                    const OccupancyBrick* brick = findBrick({bx, by, bz});
+                    if (!brick) continue;
+                    glm::ivec3 base = glm::ivec3(bx, by, bz) * OCCUPANCY_BRICK_SIZE;
+                    glm::ivec3 l = glm::max(lo - base, glm::ivec3(0));
+                    glm::ivec3 h = glm::min(hi - base, glm::ivec3(OCCUPANCY_BRICK_SIZE - 1));
+                    uint64_t mask = sliceMask(l.x, h.x, l.y, h.y);
+                    for (int z = l.z; z <= h.z; ++z)
+                        if (brick->bits[z] & mask) return true;
+                }
+        return false;
+    }
+
+    // Whether a sphere of `radius` world units around `pos` is clear,
+    // conservatively (the voxel box bounding the sphere is tested).
+    bool isFree(const glm::vec3& pos, float radius) const {
+        return !anyOccupied(toVoxel(pos - glm::vec3(radius)), toVoxel(pos + glm::vec3(radius)));
+    }
+
+    // First occupied voxel along the ray within maxDistance (in units of
+    // |direction|), by a 3D DDA. The hash is only consulted when the ray
+    // enters a new brick, and bricks that do not exist are crossed in one
+    // jump rather than voxel by voxel.
+    bool raymarch(const glm::vec3& start, const glm::vec3& direction, float maxDistance,
+                  glm::ivec3& hitVoxel, float& hitDistance) const {
+        glm::vec3 p = (start - origin) / voxelSize;
+        glm::ivec3 step(direction.x > 0.0f ? 1 : -1, direction.y > 0.0f ? 1 : -1, direction.z > 0.0f ? 1 : -1);
+        glm::vec3 delta;
+        for (int k = 0; k < 3; ++k)
+            delta[k] = direction[k] != 0.0f ? voxelSize / std::abs(direction[k]) : 1e30f;
+
+        // Ray parameter at which each axis next crosses a voxel boundary.
+        glm::ivec3 v = glm::ivec3(glm::floor(p));
+        glm::vec3 next;
+        auto restart = [&]() {
+            for (int k = 0; k < 3; ++k) {
+                float boundary = step[k] > 0 ? float(v[k] + 1) - p[k] : p[k] - float(v[k]);
+                next[k] = direction[k] != 0.0f ? boundary * delta[k] : 1e30f;
+            }
+        };
+        restart();
+
+        float t = 0.0f;
+        while (t <= maxDistance) {
+            glm::ivec3 b = brickOf(v);
+            const OccupancyBrick* brick = findBrick(b);
+            if (!brick) {
+                // Jump to where the ray leaves this brick. Rounding at brick
+                // corners can put that behind t; then take one voxel step.
+                glm::ivec3 base = b * OCCUPANCY_BRICK_SIZE;
+                glm::vec3 exit;
+                for (int k = 0; k < 3; ++k) {
+                    float boundary = step[k] > 0 ? float(base[k] + OCCUPANCY_BRICK_SIZE) - p[k] : p[k] - float(base[k]);
+                    exit[k] = direction[k] != 0.0f ? boundary * delta[k] : 1e30f;
+                }
+                int axis = exit.x < exit.y ? (exit.x < exit.z ? 0 : 2) : (exit.y < exit.z ? 1 : 2);
+                if (exit[axis] > t) {
+                    t = exit[axis];
+                    v = glm::ivec3(glm::floor(p + direction / voxelSize * t));
+                    v[axis] = step[axis] > 0 ? base[axis] + OCCUPANCY_BRICK_SIZE : base[axis] - 1;
+                    restart();
+                } else {
+                    axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+                    t = next[axis];
+                    next[axis] += delta[axis];
+                    v[axis] += step[axis];
+                }
+                continue;
+            }
+
+            // Walk voxels until the ray leaves the brick.
+            while (t <= maxDistance && brickOf(v) == b) {
+                if (testBit(*brick, v)) {
+                    hitVoxel = v;
+                    hitDistance = t;
+                    return true;
+                }
+                int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+                t = next[axis];
+                next[axis] += delta[axis];
+                v[axis] += step[axis];
+            }
+        }
+        return false;
+    }
+
+    size_t occupiedCount() const { return occupied; }
+    size_t brickCount() const { return bricks.size(); }
+
+    OccupancyMemory memory() const {
+        OccupancyMemory m;
+        m.bricks = bricks.size();
+        m.occupiedVoxels = occupied;
+        m.bytes = bricks.capacity() * sizeof(OccupancyBrick) + keys.capacity() * (sizeof(uint64_t) + sizeof(uint32_t));
+        m.bytesPerMillionOccupied = occupied ? double(m.bytes) * 1e6 / double(occupied) : 0.0;
+        m.bytesPerMillionDense = 1e6 * double(sizeof(GridCell));
+        return m;
+    }
+
+private:
+    std::vector<OccupancyBrick> bricks;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> slots;
+    size_t occupied;
+
+    static glm::ivec3 brickOf(const glm::ivec3& v) { return v >> 3; }
+
+    void rasterizeInBrick(const glm::vec3* v, const glm::vec3& pad, const glm::ivec3& base,
+                          const glm::ivec3& lo, const glm::ivec3& hi) {
+        OccupancyBrick* brick = nullptr;
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x) {
+                    glm::vec3 cellMin = origin + glm::vec3(x, y, z) * voxelSize;
+                    if (!World::triangleOverlapsBox(v, cellMin - pad, cellMin + voxelSize + pad)) continue;
+                    if (!brick) brick = &getOrAddBrick(brickOf(base));
+                    uint64_t mask = uint64_t(1) << ((y - base.y) * OCCUPANCY_BRICK_SIZE + (x - base.x));
+                    occupied += (brick->bits[z - base.z] & mask) ? 0 : 1;
+                    brick->bits[z - base.z] |= mask;
+                }
+    }
+
+    static bool testBit(const OccupancyBrick& brick, const glm::ivec3& v) {
+        glm::ivec3 l = v & (OCCUPANCY_BRICK_SIZE - 1);
+        return (brick.bits[l.z] >> (l.y * OCCUPANCY_BRICK_SIZE + l.x)) & 1;
+    }
+
+    // Bits for x in [x0, x1] and y in [y0, y1] of one slice.
+    static uint64_t sliceMask(int x0, int x1, int y0, int y1) {
+        uint64_t row = ((uint64_t(1) << (x1 - x0 + 1)) - 1) << x0;
+        uint64_t mask = 0;
+        for (int y = y0; y <= y1; ++y) mask |= row << (y * OCCUPANCY_BRICK_SIZE);
+        return mask;
+    }
+
+    static uint64_t packKey(const glm::ivec3& b) {
+        const uint64_t bias = uint64_t(1) << 20;
+        return ((uint64_t(b.x) + bias) & 0x1fffff) | (((uint64_t(b.y) + bias) & 0x1fffff) << 21) |
+               (((uint64_t(b.z) + bias) & 0x1fffff) << 42);
+    }
+
+    size_t slotOf(uint64_t key) const {
+        return size_t((key * 0x9e3779b97f4a7c15ull) >> 32) & (keys.size() - 1);
+    }
+
+    const OccupancyBrick* findBrick(const glm::ivec3& b) const {
+        uint64_t key = packKey(b);
+        for (size_t s = slotOf(key);; s = (s + 1) & (keys.size() - 1)) {
+            if (keys[s] == key) return &bricks[slots[s]];
+            if (keys[s] == OCCUPANCY_EMPTY_KEY) return nullptr;
+        }
+    }
+
+    OccupancyBrick& getOrAddBrick(const glm::ivec3& b) {
+        uint64_t key = packKey(b);
+        size_t s = slotOf(key);
+        for (; keys[s] != OCCUPANCY_EMPTY_KEY; s = (s + 1) & (keys.size() - 1))
+            if (keys[s] == key) return bricks[slots[s]];
+
+        // Keep the load factor at or below one half.
+        if (2 * (bricks.size() + 1) > keys.size()) {
+            resizeTable(keys.size() * 2);
+            return getOrAddBrick(b);
+        }
+        keys[s] = key;
+        slots[s] = uint32_t(bricks.size());
+        bricks.push_back(OccupancyBrick{});
+        return bricks.back();
+    }
+
+    void resizeTable(size_t capacity) {
+        std::vector<uint64_t> oldKeys(capacity, OCCUPANCY_EMPTY_KEY);
+        std::vector<uint32_t> oldSlots(capacity);
+        oldKeys.swap(keys);
+        oldSlots.swap(slots);
+        for (size_t s = 0; s < oldKeys.size(); ++s) {
+            if (oldKeys[s] == OCCUPANCY_EMPTY_KEY) continue;
+            size_t t = slotOf(oldKeys[s]);
+            while (keys[t] != OCCUPANCY_EMPTY_KEY) t = (t + 1) & (keys.size() - 1);
+            keys[t] = oldKeys[s];
+            slots[t] = oldSlots[s];
+        }
+    }
+};
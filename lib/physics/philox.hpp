@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+#ifndef PHILOX_ROUNDS
+    #define PHILOX_ROUNDS 10
+#endif
+
+// Philox4x32 counter-based generator (Salmon et al., "Parallel Random
+// Numbers: As Easy as 1, 2, 3"). The output is a pure function of a 128-bit
+// counter and a 64-bit key, so any stream position can be produced directly
+// on any thread without shared state, and every draw is reproducible.
+struct Philox4x32 {
+    static void generate(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+
+        for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+            uint64_t p0 = uint64_t(PHILOX_M0) * c0;
+            uint64_t p1 = uint64_t(PHILOX_M1) * c2;
+            uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+            c1 = uint32_t(p1);
+            c3 = uint32_t(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+
+        out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+    }
+};
+
+// Maps 32 random bits to a float in the open interval (0, 1).
+inline float philoxUniform(uint32_t x) {
+    return (float(x >> 8) + 0.5f) * (1.0f / 16777216.0f);
+}
+
+// Fills `out` with 4 * blocks standard normal deviates from the stream
+// identified by `key`. Block b uses counter {counterLo + b, counterHi, 0, 0}.
+// The lane loops are branch-free so the compiler can batch them.
+inline void philoxNormals(const uint32_t key[2], uint32_t counterLo, uint32_t counterHi, size_t blocks, float* out) {
+    const float twoPi = 6.28318530718f;
+
+    for (size_t b = 0; b < blocks; ++b) {
+        uint32_t counter[4] = {counterLo + uint32_t(b), counterHi, 0u, 0u};
+        uint32_t bits[4];
+        Philox4x32::generate(counter, key, bits);
+
+        for (int pair = 0; pair < 2; ++pair) {
+            float u1 = philoxUniform(bits[pair * 2]);
+            float u2 = philoxUniform(bits[pair * 2 + 1]);
+            float radius = std::sqrt(-2.0f * std::log(u1));
+            out[b * 4 + pair * 2]     = radius * std::cos(twoPi * u2);
+            out[b * 4 + pair * 2 + 1] = radius * std::sin(twoPi * u2);
+        }
+    }
+}
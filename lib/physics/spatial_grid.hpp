@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 
 #include <vector>
+#include <cmath>
 
 struct GridCell {
     std::vector<int> obstacleIndices;
@@ -19,29 +20,86 @@ public:
         cells.resize(cellsX * cellsY * cellsZ);
     }
 
+    // Empties every cell but keeps their storage, so a grid rebuilt each
+    // step stops allocating once it has warmed up.
+    void clear() {
+        for (auto& cell : cells)
+            cell.obstacleIndices.clear();
+    }
+
+    // Positions outside the bounds are stored in the nearest edge cell.
     void insertObstacle(int index, const glm::vec3& pos) {
         glm::ivec3 c = toCellCoords(pos);
         cells[cellIndex(c)].obstacleIndices.push_back(index);
     }
 
-    std::vector<int> queryNearby(const glm::vec3& pos, float radius) {
-        glm::ivec3 cmin = toCellCoords(pos - glm::vec3(radius));
-        glm::ivec3 cmax = toCellCoords(pos + glm::vec3(radius));
+    // Stores an extended object in every cell its bounds overlap, so a box
+    // query finds it from any of them (possibly more than once).
+    void insertBox(int index, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        glm::ivec3 cmin = toCellCoords(boxMin);
+        glm::ivec3 cmax = toCellCoords(boxMax);
+        for (int z = cmin.z; z <= cmax.z; z++)
+            for (int y = cmin.y; y <= cmax.y; y++)
+                for (int x = cmin.x; x <= cmax.x; x++)
+                    cells[cellIndex({x, y, z})].obstacleIndices.push_back(index);
+    }
 
+    std::vector<int> queryNearby(const glm::vec3& pos, float radius) const {
         std::vector<int> results;
-        for (int x = cmin.x; x <= cmax.x; x++) {
+        queryNearby(pos, radius, results);
+        return results;
+    }
+
+    // Replaces the contents of `results`, reusing its storage.
+    void queryNearby(const glm::vec3& pos, float radius, std::vector<int>& results) const {
+        queryBox(pos - glm::vec3(radius), pos + glm::vec3(radius), results);
+    }
+
+    // Everything in the cells overlapping [boxMin, boxMax].
+    void queryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<int>& results) const {
+        results.clear();
+        forEachInBox(boxMin, boxMax, [&](int index) { results.push_back(index); });
+    }
+
+    // Calls fn(index) for everything in the cells overlapping [boxMin, boxMax]
+    // without gathering the indices first.
+    template <typename F>
+    void forEachInBox(const glm::vec3& boxMin, const glm::vec3& boxMax, F&& fn) const {
+        glm::ivec3 cmin = toCellCoords(boxMin);
+        glm::ivec3 cmax = toCellCoords(boxMax);
+
+        for (int z = cmin.z; z <= cmax.z; z++) {
             for (int y = cmin.y; y <= cmax.y; y++) {
-                for (int z = cmin.z; z <= cmax.z; z++) {
-                    if (inBounds(x, y, z)) {
-                        auto& cell = cells[cellIndex({x, y, z})];
-                        results.insert(results.end(),
-                                       cell.obstacleIndices.begin(),
-                                       cell.obstacleIndices.end());
+                const GridCell* row = &cells[cellIndex({cmin.x, y, z})];
+                for (int x = 0; x <= cmax.x - cmin.x; x++) {
+                    for (int index : row[x].obstacleIndices)
+                        fn(index);
+                }
+            }
+        }
+    }
+
+    // Calls fn(cellMin, cellMax, indices) for every non-empty cell. Border
+    // cells also hold anything clamped into them from outside the bounds,
+    // so their extent is open towards the outside.
+    template <typename F>
+    void forEachCell(F&& fn) const {
+        for (int z = 0; z < cellsZ; z++) {
+            for (int y = 0; y < cellsY; y++) {
+                for (int x = 0; x < cellsX; x++) {
+                    const GridCell& cell = cells[cellIndex({x, y, z})];
+                    if (cell.obstacleIndices.empty()) continue;
+                    glm::ivec3 c(x, y, z), last(cellsX - 1, cellsY - 1, cellsZ - 1);
+                    glm::vec3 lo = minBounds + glm::vec3(c) * cellSize;
+                    glm::vec3 hi = lo + cellSize;
+                    for (int k = 0; k < 3; ++k) {
+                        if (c[k] == 0) lo[k] = -1e30f;
+                        if (c[k] == last[k]) hi[k] = 1e30f;
                     }
+                    fn(lo, hi, cell.obstacleIndices);
                 }
             }
         }
-        return results;
     }
 
 private:
@@ -52,7 +110,8 @@ private:
 
     glm::ivec3 toCellCoords(const glm::vec3& pos) const {
         glm::vec3 rel = pos - minBounds;
-        return glm::ivec3(rel.x / cellSize, rel.y / cellSize, rel.z / cellSize);
+        glm::ivec3 c(std::floor(rel.x / cellSize), std::floor(rel.y / cellSize), std::floor(rel.z / cellSize));
+        return glm::clamp(c, glm::ivec3(0), glm::ivec3(cellsX - 1, cellsY - 1, cellsZ - 1));
     }
 
     bool inBounds(int x, int y, int z) const {
@@ -57,7 +57,7 @@ public:
         return false;
     }
 
-    void render(Shader shader) {
+    void render(Shader& shader) {
         if (boundingSphere)
             boundingSphere->render(shader, GL_LINE);
     }
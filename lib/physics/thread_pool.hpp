@@ -0,0 +1,119 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+
+// Fixed set of worker threads that execute parallelFor ranges. The calling
+// thread takes part as worker 0, so worker indices run from 0 to size() - 1
+// and can be used to pick per-thread scratch buffers. parallelFor must not be
+// called from inside another parallelFor on the same pool.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount = 0)
+        : jobContext(nullptr), jobInvoke(nullptr), jobCount(0), jobGrain(1), next(0), active(0), generation(0), stopping(false)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        workerCount = threadCount;
+
+        for (unsigned int i = 1; i < workerCount; ++i)
+            threads.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return workerCount; }
+
+    // Runs fn(begin, end, worker) over chunks of [0, count). The callable is
+    // invoked through a plain function pointer, so no std::function is built.
+    template <typename F>
+    void parallelFor(size_t count, F&& fn, size_t grain = 0) {
+        if (count == 0) return;
+        if (grain == 0)
+            grain = std::max<size_t>(1, count / (size_t(workerCount) * 4));
+
+        if (workerCount == 1 || count <= grain) {
+            fn(0, count, 0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobContext = const_cast<void*>(static_cast<const void*>(&fn));
+            jobInvoke = [](void* ctx, size_t begin, size_t end, unsigned int worker) {
+                (*static_cast<std::remove_reference_t<F>*>(ctx))(begin, end, worker);
+            };
+            jobCount = count;
+            jobGrain = grain;
+            next = 0;
+            active = workerCount - 1;
+            ++generation;
+        }
+        wake.notify_all();
+
+        runChunks(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        jobContext = nullptr;
+    }
+
+private:
+    std::vector<std::thread> threads;
+    unsigned int workerCount;
+
+    void* jobContext;
+    void (*jobInvoke)(void*, size_t, size_t, unsigned int);
+    size_t jobCount;
+    size_t jobGrain;
+    std::atomic<size_t> next;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned int active;
+    size_t generation;
+    bool stopping;
+
+    void workerLoop(unsigned int index) {
+        size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+
+            runChunks(index);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0)
+                done.notify_one();
+        }
+    }
+
+    void runChunks(unsigned int worker) {
+        while (true) {
+            size_t begin = next.fetch_add(jobGrain);
+            if (begin >= jobCount) break;
+            jobInvoke(jobContext, begin, std::min(begin + jobGrain, jobCount), worker);
+        }
+    }
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <complex>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "philox.hpp"
+#include "mapped_file.hpp"
+
+#define WIND_FIELD_MAGIC 0x444e4957u // "WIND"
+
+struct WindFieldHeader {
+    uint32_t magic;
+    uint32_t resolution;
+    float cellSize;
+    float lengthScale;
+};
+
+// In-place radix-2 FFT of n complex values spaced `stride` apart.
+inline void windFft(std::complex<float>* data, int n, int stride, bool inverse) {
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(data[i * stride], data[j * stride]);
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        float angle = (inverse ? 2.0f : -2.0f) * 3.14159265359f / float(len);
+        std::complex<float> step(std::cos(angle), std::sin(angle));
+        for (int i = 0; i < n; i += len) {
+            std::complex<float> w(1.0f, 0.0f);
+            for (int k = 0; k < len / 2; ++k) {
+                std::complex<float> a = data[(i + k) * stride];
+                std::complex<float> b = data[(i + k + len / 2) * stride] * w;
+                data[(i + k) * stride] = a + b;
+                data[(i + k + len / 2) * stride] = a - b;
+                w *= step;
+            }
+        }
+    }
+}
+
+// Mean wind plus frozen turbulence. The turbulence is a periodic cube of
+// resolution^3 velocity samples with unit RMS per component, shaped by the
+// von Karman spectrum and tiled over all of space; it is advected with the
+// mean wind (Taylor's hypothesis) and scaled by `intensity`. The cube is
+// either baked at startup or memory-mapped from a file written by save().
+class WindField {
+public:
+    glm::vec3 meanWind;
+    float intensity;
+
+    WindField() : meanWind(0.0f), intensity(0.0f), resolution(0), mask(0), cellSize(1.0f), lengthScale(0.0f), voxels(nullptr) {}
+
+    WindField(const WindField&) = delete;
+    WindField& operator=(const WindField&) = delete;
+
+    int getResolution() const { return resolution; }
+    float getCellSize() const { return cellSize; }
+    bool isValid() const { return voxels != nullptr; }
+
+    // Synthesises the turbulence cube in the frequency domain. `resolution`
+    // must be a power of two; `lengthScale` is the von Karman integral scale
+    // in world units.
+    bool bake(int _resolution, float _cellSize, float _lengthScale, uint32_t seed = 1) {
+        if (_resolution < 2 || (_resolution & (_resolution - 1)) != 0) {
+            std::cerr << "Error: Wind field resolution must be a power of two.\n";
+            return false;
+        }
+        const int n = _resolution;
+        const size_t count = size_t(n) * n * n;
+        const float dk = 2.0f * 3.14159265359f / (float(n) * _cellSize);
+
+        owned.assign(count * 3, 0.0f);
+        std::vector<std::complex<float>> spectrum(count);
+        uint32_t key[2] = {seed, WIND_FIELD_MAGIC};
+
+        for (int c = 0; c < 3; ++c) {
+            for (int z = 0; z < n; ++z)
+                for (int y = 0; y < n; ++y)
+                    for (int x = 0; x < n; ++x) {
+                        size_t v = (size_t(z) * n + y) * n + x;
+                        glm::vec3 k = dk * glm::vec3(wrapFrequency(x, n), wrapFrequency(y, n), wrapFrequency(z, n));
+                        float kl2 = glm::dot(k, k) * _lengthScale * _lengthScale;
+
+                        // E(k) ~ (kL)^4 / (1 + (kL)^2)^(17/6), spread over a shell of area k^2.
+                        float amplitude = 0.0f;
+                        if (kl2 > 0.0f)
+                            amplitude = std::sqrt(kl2 / std::pow(1.0f + kl2, 17.0f / 6.0f));
+
+                        float e[4];
+                        philoxNormals(key, uint32_t(v), uint32_t(c), 1, e);
+                        spectrum[v] = amplitude * std::complex<float>(e[0], e[1]);
+                    }
+
+            for (int z = 0; z < n; ++z)
+                for (int y = 0; y < n; ++y)
+                    windFft(&spectrum[(size_t(z) * n + y) * n], n, 1, true);
+            for (int z = 0; z < n; ++z)
+                for (int x = 0; x < n; ++x)
+                    windFft(&spectrum[size_t(z) * n * n + x], n, n, true);
+            for (int y = 0; y < n; ++y)
+                for (int x = 0; x < n; ++x)
+                    windFft(&spectrum[size_t(y) * n + x], n, n * n, true);
+
+            double sum = 0.0, sumSq = 0.0;
+            for (size_t v = 0; v < count; ++v) {
+                sum += spectrum[v].real();
+                sumSq += double(spectrum[v].real()) * spectrum[v].real();
+            }
+            double mean = sum / double(count);
+            double rms = std::sqrt(std::max(sumSq / double(count) - mean * mean, 1e-20));
+            for (size_t v = 0; v < count; ++v)
+                owned[v * 3 + c] = float((spectrum[v].real() - mean) / rms);
+        }
+
+        mapped.close();
+        setCube(owned.data(), n, _cellSize, _lengthScale);
+        return true;
+    }
+
+    bool save(const std::string& path) const {
+        if (!voxels) {
+            std::cerr << "Error: No wind field to save.\n";
+            return false;
+        }
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open wind field file for writing: " << path << "\n";
+            return false;
+        }
+        WindFieldHeader header = {WIND_FIELD_MAGIC, uint32_t(resolution), cellSize, lengthScale};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(voxels), voxelCount() * 3 * sizeof(float));
+        return bool(file);
+    }
+
+    // Maps a cube written by save(); the samples are used in place. On
+    // failure the field is left without a cube and samples the mean wind.
+    bool load(const std::string& path) {
+        MappedFile file;
+        bool ok = file.open(path);
+        WindFieldHeader header;
+        if (ok && file.getSize() < sizeof(header)) {
+            std::cerr << "Error: Wind field file is truncated: " << path << "\n";
+            ok = false;
+        }
+        size_t n = 0;
+        if (ok) {
+            std::memcpy(&header, file.getData(), sizeof(header));
+            n = header.resolution;
+            if (header.magic != WIND_FIELD_MAGIC || n < 2 || (n & (n - 1)) != 0 ||
+                file.getSize() < sizeof(header) + n * n * n * 3 * sizeof(float)) {
+                std::cerr << "Error: Invalid wind field file: " << path << "\n";
+                ok = false;
+            }
+        }
+        if (!ok) {
+            voxels = nullptr;
+            resolution = 0;
+            mask = 0;
+            return false;
+        }
+
+        mapped.swap(file);
+        owned.clear();
+        setCube(reinterpret_cast<const float*>(mapped.getData() + sizeof(header)), int(n), header.cellSize, header.lengthScale);
+        return true;
+    }
+
+    glm::vec3 sample(const glm::vec3& position, float time) const {
+        glm::vec3 out;
+        sample(&position, 1, time, &out);
+        return out;
+    }
+
+    // Trilinear lookups for a batch of positions at one time. The loop body
+    // is branch-free and the cube wraps with a mask, never a modulo.
+    void sample(const glm::vec3* positions, size_t count, float time, glm::vec3* out) const {
+        if (!voxels || intensity == 0.0f) {
+            for (size_t i = 0; i < count; ++i) out[i] = meanWind;
+            return;
+        }
+
+        const float invCell = 1.0f / cellSize;
+        const glm::vec3 offset = meanWind * time;
+        const int n = resolution;
+
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 p = (positions[i] - offset) * invCell;
+            glm::vec3 base = glm::floor(p);
+            glm::vec3 f = p - base;
+            int x0 = int(base.x) & mask, y0 = int(base.y) & mask, z0 = int(base.z) & mask;
+            int x1 = (x0 + 1) & mask, y1 = (y0 + 1) & mask, z1 = (z0 + 1) & mask;
+
+            const float* c000 = voxels + ((size_t(z0) * n + y0) * n + x0) * 3;
+            const float* c100 = voxels + ((size_t(z0) * n + y0) * n + x1) * 3;
+            const float* c010 = voxels + ((size_t(z0) * n + y1) * n + x0) * 3;
+            const float* c110 = voxels + ((size_t(z0) * n + y1) * n + x1) * 3;
+            const float* c001 = voxels + ((size_t(z1) * n + y0) * n + x0) * 3;
+            const float* c101 = voxels + ((size_t(z1) * n + y0) * n + x1) * 3;
+            const float* c011 = voxels + ((size_t(z1) * n + y1) * n + x0) * 3;
+            const float* c111 = voxels + ((size_t(z1) * n + y1) * n + x1) * 3;
+
+            glm::vec3 turbulence;
+            for (int c = 0; c < 3; ++c) {
+                float a = c000[c] + (c100[c] - c000[c]) * f.x;
+                float b = c010[c] + (c110[c] - c010[c]) * f.x;
+                float d = c001[c] + (c101[c] - c001[c]) * f.x;
+                float e = c011[c] + (c111[c] - c011[c]) * f.x;
+                float lo = a + (b - a) * f.y;
+                float hi = d + (e - d) * f.y;
+                turbulence[c] = lo + (hi - lo) * f.z;
+            }
+            out[i] = meanWind + intensity * turbulence;
+        }
+    }
+
+private:
+    int resolution;
+    int mask;
+    float cellSize;
+    float lengthScale;
+    const float* voxels;
+
+    std::vector<float> owned;
+    MappedFile mapped;
+
+    static float wrapFrequency(int i, int n) {
+        return float(i < n / 2 ? i : i - n);
+    }
+
+    size_t voxelCount() const { return size_t(resolution) * resolution * resolution; }
+
+    void setCube(const float* data, int n, float _cellSize, float _lengthScale) {
+        voxels = data;
+        resolution = n;
+        mask = n - 1;
+        cellSize = _cellSize;
+        lengthScale = _lengthScale;
+    }
+};
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <unordered_map>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+#include "bvh.hpp"
+#include "contact_solver.hpp"
+
+// Triangle geometry of one asset, centred on its bounds like Mesh does, so
+// an instance placed at a position lines up with a Mesh loaded from the
+// same file and given the same transform.
+struct CollisionMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    Bvh bvh;
+
+    size_t triangleCount() const { return indices.size() / 3; }
+
+    void buildBvh() {
+        size_t count = triangleCount();
+        std::vector<glm::vec3> lo(count), hi(count);
+        for (size_t t = 0; t < count; ++t) {
+            const glm::vec3& a = positions[indices[3 * t]];
+            const glm::vec3& b = positions[indices[3 * t + 1]];
+            const glm::vec3& c = positions[indices[3 * t + 2]];
+            lo[t] = glm::min(glm::min(a, b), c);
+            hi[t] = glm::max(glm::max(a, b), c);
+        }
+        bvh.build(lo, hi);
+    }
+};
+
+// GL-free OBJ reader for collision: only `v` and `f` lines are used. Faces
+// may use any of the v, v/t, v//n and v/t/n forms, negative indices, and
+// more than three corners (fanned into triangles).
+inline bool loadCollisionObj(const std::string& path, CollisionMesh& mesh) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open OBJ file: " << path << "\n";
+        return false;
+    }
+
+    mesh.positions.clear();
+    mesh.indices.clear();
+
+    std::string line, prefix, corner;
+    std::stringstream ss;
+    std::vector<uint32_t> face;
+    while (std::getline(file, line)) {
+        ss.clear();
+        ss.str(line);
+        prefix.clear();
+        ss >> prefix;
+
+        if (prefix == "v") {
+            glm::vec3 v;
+            ss >> v.x >> v.y >> v.z;
+            mesh.positions.push_back(v);
+        } else if (prefix == "f") {
+            face.clear();
+            while (ss >> corner) {
+                long index = std::strtol(corner.c_str(), nullptr, 10);
+                index = index < 0 ? long(mesh.positions.size()) + index : index - 1;
+                if (index < 0 || index >= long(mesh.positions.size())) {
+                    std::cerr << "Error: OBJ face index out of range in " << path << "\n";
+                    return false;
+                }
+                face.push_back(uint32_t(index));
+            }
+            for (size_t k = 2; k < face.size(); ++k) {
+                mesh.indices.push_back(face[0]);
+                mesh.indices.push_back(face[k - 1]);
+                mesh.indices.push_back(face[k]);
+            }
+        }
+    }
+
+    if (mesh.indices.empty()) {
+        std::cerr << "Error: OBJ file has no faces: " << path << "\n";
+        return false;
+    }
+
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (const glm::vec3& v : mesh.positions) {
+        lo = glm::min(lo, v);
+        hi = glm::max(hi, v);
+    }
+    glm::vec3 origin = 0.5f * (lo + hi);
+    for (glm::vec3& v : mesh.positions) v -= origin;
+
+    mesh.buildBvh();
+    return true;
+}
+
+struct WorldInstance {
+    uint32_t asset;
+    glm::mat4 model;
+    glm::mat4 inverse;
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct WorldHit {
+    float distance;
+    glm::vec3 point;
+    glm::vec3 normal;
+    uint32_t instance;
+};
+
+// Static collision world made of instances of shared assets. Each asset has
+// its own triangle BVH in local space (bottom level) and a second BVH is
+// built over the world bounds of the instances (top level), so a query
+// touches only the instances near it and then only the triangles near it
+// inside each; thousands of copies of one building cost one triangle tree.
+//
+// Scene files are text, one directive per line, '#' starting a comment:
+//     asset <name> <obj path>
+//     instance <name> <x y z> [<rx ry rz degrees> [<sx sy sz>]]
+// Rotations are Euler angles as Mesh::setRotation takes them, and OBJ paths
+// are relative to the working directory like the Mesh constructor's.
+class World {
+public:
+    std::vector<CollisionMesh> assets;
+    std::vector<WorldInstance> instances;
+
+    int addAsset(const std::string& name, const std::string& path) {
+        auto it = assetNames.find(name);
+        if (it != assetNames.end()) return it->second;
+
+        CollisionMesh mesh;
+        if (!loadCollisionObj(path, mesh)) return -1;
+        assets.push_back(std::move(mesh));
+        assetNames[name] = int(assets.size() - 1);
+        return int(assets.size() - 1);
+    }
+
+    void addInstance(uint32_t asset, const glm::vec3& position, const glm::vec3& eulerAngles = glm::vec3(0.0f),
+                     const glm::vec3& scale = glm::vec3(1.0f)) {
+        WorldInstance instance;
+        instance.asset = asset;
+        instance.model = glm::translate(glm::mat4(1.0f), position) * glm::toMat4(glm::quat(eulerAngles));
+        instance.model = glm::scale(instance.model, scale);
+        instance.inverse = glm::inverse(instance.model);
+
+        const Bvh& bvh = assets[asset].bvh;
+        transformBounds(instance.model, bvh.nodes[0].min, bvh.nodes[0].max, instance.min, instance.max);
+        instances.push_back(instance);
+    }
+
+    // Builds the top-level tree; call after the last addInstance.
+    void build() {
+        std::vector<glm::vec3> lo(instances.size()), hi(instances.size());
+        for (size_t i = 0; i < instances.size(); ++i) {
+            lo[i] = instances[i].min;
+            hi[i] = instances[i].max;
+        }
+        top.build(lo, hi);
+    }
+
+    bool loadScene(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open scene file: " << path << "\n";
+            return false;
+        }
+
+        std::string line, directive, name, objPath;
+        std::stringstream ss;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            ++lineNumber;
+            line = line.substr(0, line.find('#'));
+            ss.clear();
+            ss.str(line);
+            directive.clear();
+            ss >> directive;
+
+            if (directive.empty()) {
+                continue;
+            } else if (directive == "asset") {
+                if (!(ss >> name >> objPath) || addAsset(name, objPath) < 0) {
+                    std::cerr << "Error: Bad asset on line " << lineNumber << " of " << path << "\n";
+                    return false;
+                }
+            } else if (directive == "instance") {
+                glm::vec3 position, degrees(0.0f), scale(1.0f);
+                auto it = assetNames.end();
+                if (ss >> name) it = assetNames.find(name);
+                if (it == assetNames.end() || !(ss >> position.x >> position.y >> position.z)) {
+                    std::cerr << "Error: Bad instance on line " << lineNumber << " of " << path << "\n";
+                    return false;
+                }
+                if (ss >> degrees.x >> degrees.y >> degrees.z)
+                    ss >> scale.x >> scale.y >> scale.z;
+                addInstance(uint32_t(it->second), position, glm::radians(degrees), scale);
+            } else {
+                std::cerr << "Error: Unknown directive '" << directive << "' on line " << lineNumber << " of " << path << "\n";
+                return false;
+            }
+        }
+
+        build();
+        return true;
+    }
+
+    size_t triangleCount() const {
+        size_t count = 0;
+        for (const WorldInstance& instance : instances)
+            count += assets[instance.asset].triangleCount();
+        return count;
+    }
+
+    bool overlapsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+        bool hit = false;
+        forEachTriangleInBox(boxMin, boxMax, [&](uint32_t, const glm::vec3*) {
+            hit = true;
+            return false;
+        });
+        return hit;
+    }
+
+    // Nearest hit along the ray within maxDistance. `direction` need not be
+    // normalised; the distance is in units of its length.
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, WorldHit& hit) const {
+        bool found = false;
+        top.forEachRayHit(origin, direction, maxDistance, [&](uint32_t i, float& limit) {
+            const WorldInstance& instance = instances[i];
+            const CollisionMesh& mesh = assets[instance.asset];
+            // An affine map preserves the ray parameter, so distances found in
+            // local space are valid in world space.
+            glm::vec3 localOrigin = glm::vec3(instance.inverse * glm::vec4(origin, 1.0f));
+            glm::vec3 localDir = glm::vec3(instance.inverse * glm::vec4(direction, 0.0f));
+
+            mesh.bvh.forEachRayHit(localOrigin, localDir, limit, [&](uint32_t t, float& localLimit) {
+                const glm::vec3& a = mesh.positions[mesh.indices[3 * t]];
+                const glm::vec3& b = mesh.positions[mesh.indices[3 * t + 1]];
+                const glm::vec3& c = mesh.positions[mesh.indices[3 * t + 2]];
+                float distance;
+                if (!rayTriangle(localOrigin, localDir, a, b, c, distance) || distance >= localLimit) return;
+                localLimit = distance;
+                found = true;
+                hit.distance = distance;
+                hit.instance = i;
+                hit.normal = glm::normalize(glm::transpose(glm::mat3(instance.inverse)) * glm::cross(b - a, c - a));
+            });
+        });
+        if (found) {
+            hit.point = origin + direction * hit.distance;
+            if (glm::dot(hit.normal, direction) > 0.0f) hit.normal = -hit.normal;
+        }
+        return found;
+    }
+
+    // Deepest contact between a box and the world's triangles, treated as
+    // two-sided planes clipped to their triangles. `motion` is how far the
+    // box moved over the last step: triangles are gathered over the swept
+    // box and each normal faces where the box came from, so a fast box that
+    // has passed through a zero-thickness wall is still pushed back out.
+    bool boxContact(const glm::vec3& boxMin, const glm::vec3& boxMax, Contact& out,
+                    const glm::vec3& motion = glm::vec3(0.0f)) const {
+        glm::vec3 center = 0.5f * (boxMin + boxMax);
+        glm::vec3 previous = center - motion;
+        glm::vec3 extent = 0.5f * (boxMax - boxMin);
+        bool found = false;
+        out.depth = 0.0f;
+
+        forEachTriangleInBox(glm::min(boxMin, boxMin - motion), glm::max(boxMax, boxMax - motion), [&](uint32_t, const glm::vec3* v) {
+            glm::vec3 n = glm::cross(v[1] - v[0], v[2] - v[0]);
+            float length = glm::length(n);
+            if (length <= 0.0f) return true;
+            n /= length;
+            if (glm::dot(n, previous - v[0]) < 0.0f) n = -n;
+            float distance = glm::dot(n, center - v[0]);
+            float depth = glm::dot(glm::abs(n), extent) - distance;
+            if (depth > out.depth) {
+                out.depth = depth;
+                out.normal = n;
+                out.point = center - n * distance;
+                found = true;
+            }
+            return true;
+        });
+        return found;
+    }
+
+    // Calls fn(instance, worldVertices[3]) for every triangle that truly
+    // intersects the box; fn returns false to stop.
+    template <typename F>
+    void forEachTriangleInBox(const glm::vec3& boxMin, const glm::vec3& boxMax, F&& fn) const {
+        top.forEachOverlap(boxMin, boxMax, [&](uint32_t i) {
+            const WorldInstance& instance = instances[i];
+            const CollisionMesh& mesh = assets[instance.asset];
+            glm::vec3 localMin, localMax;
+            transformBounds(instance.inverse, boxMin, boxMax, localMin, localMax);
+
+            return mesh.bvh.forEachOverlap(localMin, localMax, [&](uint32_t t) {
+                glm::vec3 v[3];
+                for (int k = 0; k < 3; ++k)
+                    v[k] = glm::vec3(instance.model * glm::vec4(mesh.positions[mesh.indices[3 * t + k]], 1.0f));
+                if (!triangleOverlapsBox(v, boxMin, boxMax)) return true;
+                return bool(fn(i, v));
+            });
+        });
+    }
+
+    // Separating axis test between a triangle and an AABB (Akenine-Moller):
+    // the box axes, the triangle normal and the nine edge cross products.
+    static bool triangleOverlapsBox(const glm::vec3* tri, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        glm::vec3 center = 0.5f * (boxMin + boxMax);
+        glm::vec3 half = 0.5f * (boxMax - boxMin);
+        glm::vec3 v0 = tri[0] - center, v1 = tri[1] - center, v2 = tri[2] - center;
+
+        for (int k = 0; k < 3; ++k) {
+            float lo = std::min(std::min(v0[k], v1[k]), v2[k]);
+            float hi = std::max(std::max(v0[k], v1[k]), v2[k]);
+            if (lo > half[k] || hi < -half[k]) return false;
+        }
+
+        glm::vec3 edges[3] = {v1 - v0, v2 - v1, v0 - v2};
+        auto separated = [&](const glm::vec3& axis) {
+            float p0 = glm::dot(v0, axis), p1 = glm::dot(v1, axis), p2 = glm::dot(v2, axis);
+            float r = glm::dot(half, glm::abs(axis));
+            return std::min(std::min(p0, p1), p2) > r || std::max(std::max(p0, p1), p2) < -r;
+        };
+
+        if (separated(glm::cross(edges[0], edges[1]))) return false;
+        for (const glm::vec3& e : edges) {
+            if (separated(glm::vec3(0.0f, -e.z, e.y))) return false;
+            if (separated(glm::vec3(e.z, 0.0f, -e.x))) return false;
+            if (separated(glm::vec3(-e.y, e.x, 0.0f))) return false;
+        }
+        return true;
+    }
+
+private:
+    Bvh top;
+    std::unordered_map<std::string, int> assetNames;
+
+    static void transformBounds(const glm::mat4& m, const glm::vec3& lo, const glm::vec3& hi, glm::vec3& outMin, glm::vec3& outMax) {
+        glm::vec3 center = glm::vec3(m * glm::vec4(0.5f * (lo + hi), 1.0f));
+        glm::vec3 half = 0.5f * (hi - lo);
+        glm::vec3 extent = glm::abs(glm::vec3(m[0])) * half.x + glm::abs(glm::vec3(m[1])) * half.y + glm::abs(glm::vec3(m[2])) * half.z;
+        outMin = center - extent;
+        outMax = center + extent;
+    }
+
+    // Moller-Trumbore, two-sided.
+    static bool rayTriangle(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& a, const glm::vec3& b,
+                            const glm::vec3& c, float& distance) {
+        glm::vec3 e1 = b - a, e2 = c - a;
+        glm::vec3 p = glm::cross(dir, e2);
+        float det = glm::dot(e1, p);
+        if (std::abs(det) < 1e-12f) return false;
+        float invDet = 1.0f / det;
+        glm::vec3 s = origin - a;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) return false;
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(dir, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        distance = glm::dot(e2, q) * invDet;
+        return distance >= 0.0f;
+    }
+};
@@ -9,6 +9,7 @@
 #include <cmath>
 
 #include "shader.hpp"
+#include "frame_uniforms.hpp"
 
 #ifndef CAMERA_DEFAULT_VELOCITY    
     #define CAMERA_DEFAULT_VELOCITY   12.0f
@@ -88,9 +89,10 @@ public:
         updateViewMatrix();
     }
 
-    void setUniforms(Shader shader, const glm::mat4& projection) {
-        shader.setUniformMat4f("view", view);
-        shader.setUniformMat4f("proj", projection);
+    const glm::mat4& getView() const { return view; }
+
+    void setUniforms(FrameUniforms& frame, const glm::mat4& projection) {
+        frame.setCamera(view, projection, position);
     }
 
 private:
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "gl_handle.hpp"
+#include "shader.hpp"
+
+#ifndef FRAME_UNIFORMS_BINDING
+    #define FRAME_UNIFORMS_BINDING 0
+#endif
+
+// Mirrors the std140 FrameUniforms block in the shaders: matrices are four
+// vec4 columns, and vec3s are stored as vec4s since std140 pads them to 16
+// bytes anyway.
+struct FrameUniformData {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+    glm::vec4 viewPos;
+    glm::vec4 lightPos;
+    glm::vec4 lightColor;
+};
+
+static_assert(sizeof(FrameUniformData) == 3 * 64 + 3 * 16, "FrameUniformData must match the std140 layout");
+
+// Camera and lighting state shared by every program through one uniform
+// buffer: fill `data`, upload() once per frame, and attach() each program
+// once after it is built.
+class FrameUniforms {
+public:
+    FrameUniformData data;
+
+    FrameUniforms() : data{} {
+        buffer = makeBuffer();
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.get());
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, buffer.get());
+    }
+
+    bool attach(Shader& shader) {
+        return shader.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+    }
+
+    void setCamera(const glm::mat4& view, const glm::mat4& proj, const glm::vec3& viewPos) {
+        data.view = view;
+        data.proj = proj;
+        data.viewProj = proj * view;
+        data.viewPos = glm::vec4(viewPos, 1.0f);
+    }
+
+    void setLight(const glm::vec3& position, const glm::vec3& color) {
+        data.lightPos = glm::vec4(position, 1.0f);
+        data.lightColor = glm::vec4(color, 1.0f);
+    }
+
+    void upload() {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.get());
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &data);
+    }
+
+private:
+    BufferHandle buffer;
+};
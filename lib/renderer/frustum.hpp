@@ -0,0 +1,189 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "spatial_grid.hpp"
+
+// Boxes tested together by Frustum::cull; the loops over a block have no
+// branches, so the compiler turns them into SIMD plane tests.
+#ifndef FRUSTUM_LANES
+    #define FRUSTUM_LANES 8
+#endif
+
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_INTERSECTS 1
+#define FRUSTUM_INSIDE 2
+
+struct CullStats {
+    size_t tested;      // individual box tests
+    size_t visible;
+    size_t culled;
+    double seconds;
+};
+
+// Axis-aligned boxes as centre and half-extent arrays, one per component,
+// padded to a multiple of FRUSTUM_LANES. Padding boxes have a huge
+// negative extent, which no plane test accepts.
+struct AabbArray {
+    std::vector<float> cx, cy, cz;
+    std::vector<float> ex, ey, ez;
+    size_t count = 0;
+
+    void resize(size_t _count) {
+        count = _count;
+        size_t padded = (count + FRUSTUM_LANES - 1) / FRUSTUM_LANES * FRUSTUM_LANES;
+        for (auto* v : {&cx, &cy, &cz}) v->assign(padded, 0.0f);
+        for (auto* v : {&ex, &ey, &ez}) v->assign(padded, -1e30f);
+    }
+
+    void set(size_t i, const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 c = 0.5f * (min + max), e = 0.5f * (max - min);
+        cx[i] = c.x; cy[i] = c.y; cz[i] = c.z;
+        ex[i] = e.x; ey[i] = e.y; ez[i] = e.z;
+    }
+};
+
+// View frustum as six inward-facing planes (normalised, n.p + d >= 0
+// inside) taken from the rows of a projection * view matrix (Gribb and
+// Hartmann). Boxes are tested by their centre's distance to each plane
+// against their extent projected on its normal, which is conservative: a
+// box near a frustum corner may be reported visible when it is not.
+class Frustum {
+public:
+    glm::vec4 planes[6];
+
+    Frustum() {
+        for (glm::vec4& p : planes) p = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    explicit Frustum(const glm::mat4& viewProj) { update(viewProj); }
+
+    void update(const glm::mat4& viewProj) {
+        glm::mat4 m = glm::transpose(viewProj);
+        planes[0] = m[3] + m[0];    // left
+        planes[1] = m[3] - m[0];    // right
+        planes[2] = m[3] + m[1];    // bottom
+        planes[3] = m[3] - m[1];    // top
+        planes[4] = m[3] + m[2];    // near
+        planes[5] = m[3] - m[2];    // far
+        for (glm::vec4& p : planes) p /= glm::length(glm::vec3(p));
+    }
+
+    int classifyBox(const glm::vec3& min, const glm::vec3& max) const {
+        glm::vec3 c = 0.5f * (min + max), e = 0.5f * (max - min);
+        int result = FRUSTUM_INSIDE;
+        for (const glm::vec4& p : planes) {
+            float distance = glm::dot(glm::vec3(p), c) + p.w;
+            float reach = glm::dot(glm::abs(glm::vec3(p)), e);
+            if (distance < -reach) return FRUSTUM_OUTSIDE;
+            if (distance < reach) result = FRUSTUM_INTERSECTS;
+        }
+        return result;
+    }
+
+    bool isBoxVisible(const glm::vec3& min, const glm::vec3& max) const {
+        return classifyBox(min, max) != FRUSTUM_OUTSIDE;
+    }
+
+    // A local-space box under a model matrix, e.g. a Mesh's getBounds() and
+    // model, without transforming its corners.
+    bool isBoxVisible(const glm::vec3& min, const glm::vec3& max, const glm::mat4& model) const {
+        glm::vec3 c = glm::vec3(model * glm::vec4(0.5f * (min + max), 1.0f));
+        glm::vec3 e = 0.5f * (max - min);
+        glm::mat3 a(model);
+        for (int k = 0; k < 3; ++k) a[k] = glm::abs(a[k]);
+        e = a * e;
+        return isBoxVisible(c - e, c + e);
+    }
+
+    bool isSphereVisible(const glm::vec3& centre, float radius) const {
+        for (const glm::vec4& p : planes)
+            if (glm::dot(glm::vec3(p), centre) + p.w < -radius) return false;
+        return true;
+    }
+
+    // visible[i] = 1 for every box of the array that may be on screen, 0
+    // otherwise; returns the number visible.
+    size_t cull(const AabbArray& boxes, std::vector<uint8_t>& visible, CullStats* stats = nullptr) const {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        visible.resize(boxes.cx.size());
+
+        float nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+        for (int k = 0; k < 6; ++k) {
+            nx[k] = planes[k].x; ny[k] = planes[k].y; nz[k] = planes[k].z; d[k] = planes[k].w;
+            ax[k] = std::abs(nx[k]); ay[k] = std::abs(ny[k]); az[k] = std::abs(nz[k]);
+        }
+
+        size_t count = 0;
+        for (size_t b = 0; b < boxes.cx.size(); b += FRUSTUM_LANES) {
+            const float* cx = &boxes.cx[b]; const float* cy = &boxes.cy[b]; const float* cz = &boxes.cz[b];
+            const float* ex = &boxes.ex[b]; const float* ey = &boxes.ey[b]; const float* ez = &boxes.ez[b];
+            // Smallest margin by which the box reaches inside any plane.
+            float margin[FRUSTUM_LANES];
+            for (size_t l = 0; l < FRUSTUM_LANES; ++l) margin[l] = 3.4e38f;
+            for (int k = 0; k < 6; ++k)
+                for (size_t l = 0; l < FRUSTUM_LANES; ++l) {
+                    float distance = nx[k] * cx[l] + ny[k] * cy[l] + nz[k] * cz[l] + d[k];
+                    float reach = ax[k] * ex[l] + ay[k] * ey[l] + az[k] * ez[l];
+                    margin[l] = std::min(margin[l], distance + reach);
+                }
+            for (size_t l = 0; l < FRUSTUM_LANES; ++l) {
+                uint8_t inside = margin[l] >= 0.0f;
+                visible[b + l] = inside;
+                count += inside;
+            }
+        }
+        visible.resize(boxes.count);
+
+        if (stats) {
+            stats->tested = boxes.count;
+            stats->visible = count;
+            stats->culled = boxes.count - count;
+            stats->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - T0).count();
+        }
+        return count;
+    }
+
+    // Culls whole SpatialGrid cells before testing their members: members
+    // of cells outside the frustum are skipped, members of cells inside it
+    // are accepted untested, and only cells crossing a plane test their
+    // members' boxes. `margin` grows each cell to cover its members' full
+    // bounds (e.g. the largest half-extent for items inserted by centre; 0
+    // for items inserted with insertBox). The grid must hold indices into
+    // mins/maxs.
+    size_t cull(const SpatialGrid& grid, float margin, const std::vector<glm::vec3>& mins,
+                const std::vector<glm::vec3>& maxs, std::vector<uint8_t>& visible, CullStats* stats = nullptr) const {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        visible.assign(mins.size(), 0);
+        size_t tested = 0;
+
+        grid.forEachCell([&](const glm::vec3& cellMin, const glm::vec3& cellMax, const std::vector<int>& members) {
+            int cell = classifyBox(cellMin - margin, cellMax + margin);
+            if (cell == FRUSTUM_OUTSIDE) return;
+            for (int i : members) {
+                if (visible[i]) continue;
+                if (cell == FRUSTUM_INSIDE) {
+                    visible[i] = 1;
+                } else {
+                    visible[i] = uint8_t(isBoxVisible(mins[i], maxs[i]));
+                    ++tested;
+                }
+            }
+        });
+
+        size_t count = size_t(std::count(visible.begin(), visible.end(), uint8_t(1)));
+        if (stats) {
+            stats->tested = tested;
+            stats->visible = count;
+            stats->culled = mins.size() - count;
+            stats->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - T0).count();
+        }
+        return count;
+    }
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "gl_state.hpp"
+
+// Deleters for GlHandle; GLEW loads the GL entry points at runtime, so they
+// are wrapped in types rather than passed as template arguments.
+struct ProgramDeleter {
+    static void destroy(GLuint id) {
+        GlState::get().forgetProgram(id);
+        glDeleteProgram(id);
+    }
+};
+struct VertexArrayDeleter {
+    static void destroy(GLuint id) {
+        GlState::get().forgetVertexArray(id);
+        glDeleteVertexArrays(1, &id);
+    }
+};
+struct ShaderDeleter { static void destroy(GLuint id) { glDeleteShader(id); } };
+struct BufferDeleter { static void destroy(GLuint id) { glDeleteBuffers(1, &id); } };
+struct QueryDeleter  { static void destroy(GLuint id) { glDeleteQueries(1, &id); } };
+
+// Owns one GL object name and deletes it on destruction. Move-only, so an
+// object is deleted exactly once, by whoever holds it last; 0 means empty.
+template <typename Deleter>
+class GlHandle {
+public:
+    GlHandle() : id(0) {}
+    explicit GlHandle(GLuint _id) : id(_id) {}
+
+    ~GlHandle() { reset(); }
+
+    GlHandle(const GlHandle&) = delete;
+    GlHandle& operator=(const GlHandle&) = delete;
+
+    GlHandle(GlHandle&& other) noexcept : id(other.release()) {}
+
+    GlHandle& operator=(GlHandle&& other) noexcept {
+        if (this != &other) reset(other.release());
+        return *this;
+    }
+
+    GLuint get() const { return id; }
+    explicit operator bool() const { return id != 0; }
+
+    GLuint release() {
+        GLuint released = id;
+        id = 0;
+        return released;
+    }
+
+    void reset(GLuint _id = 0) {
+        if (id) Deleter::destroy(id);
+        id = _id;
+    }
+
+private:
+    GLuint id;
+};
+
+using ProgramHandle = GlHandle<ProgramDeleter>;
+using ShaderHandle = GlHandle<ShaderDeleter>;
+using VertexArrayHandle = GlHandle<VertexArrayDeleter>;
+using BufferHandle = GlHandle<BufferDeleter>;
+using QueryHandle = GlHandle<QueryDeleter>;
+
+inline VertexArrayHandle makeVertexArray() {
+    GLuint id = 0;
+    glGenVertexArrays(1, &id);
+    return VertexArrayHandle(id);
+}
+
+inline BufferHandle makeBuffer() {
+    GLuint id = 0;
+    glGenBuffers(1, &id);
+    return BufferHandle(id);
+}
+
+inline QueryHandle makeQuery() {
+    GLuint id = 0;
+    glGenQueries(1, &id);
+    return QueryHandle(id);
+}
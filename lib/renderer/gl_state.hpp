@@ -0,0 +1,95 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+struct GlCallStats {
+    size_t issued;      // state calls passed on to GL
+    size_t skipped;     // redundant state calls dropped
+    size_t draws;
+};
+
+// Shadow of the GL state the renderer changes per draw (current program,
+// polygon mode and vertex array), so calls that would not change it are
+// dropped. Everything that sets this state must go through here, or the
+// shadow goes stale. There is one context, driven from the render thread,
+// hence the single instance.
+class GlState {
+public:
+    static GlState& get() {
+        static GlState state;
+        return state;
+    }
+
+    // Call once per frame; returns last frame's counts.
+    GlCallStats beginFrame() {
+        GlCallStats last = stats;
+        stats = {0, 0, 0};
+        return last;
+    }
+
+    const GlCallStats& getStats() const { return stats; }
+
+    void useProgram(GLuint program) {
+        if (program == currentProgram) {
+            ++stats.skipped;
+            return;
+        }
+        glUseProgram(program);
+        currentProgram = program;
+        ++stats.issued;
+    }
+
+    void polygonMode(GLenum mode) {
+        if (mode == currentPolygonMode) {
+            ++stats.skipped;
+            return;
+        }
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        currentPolygonMode = mode;
+        ++stats.issued;
+    }
+
+    void bindVertexArray(GLuint vao) {
+        if (vao == currentVertexArray) {
+            ++stats.skipped;
+            return;
+        }
+        glBindVertexArray(vao);
+        currentVertexArray = vao;
+        ++stats.issued;
+    }
+
+    void drawElements(size_t count) {
+        glDrawElements(GL_TRIANGLES, GLsizei(count), GL_UNSIGNED_INT, nullptr);
+        ++stats.draws;
+    }
+
+    void drawElementsInstanced(size_t count, size_t instances) {
+        glDrawElementsInstanced(GL_TRIANGLES, GLsizei(count), GL_UNSIGNED_INT, nullptr, GLsizei(instances));
+        ++stats.draws;
+    }
+
+    // Deleting the bound vertex array unbinds it, and a deleted name may be
+    // handed out again, so deleted objects are dropped from the shadow.
+    void forgetVertexArray(GLuint vao) {
+        if (vao == currentVertexArray) currentVertexArray = 0;
+    }
+
+    void forgetProgram(GLuint program) {
+        if (program == currentProgram) currentProgram = INVALID;
+    }
+
+private:
+    // Forces the next call through, e.g. for a deleted program that is
+    // still in use until another one is.
+    static constexpr GLuint INVALID = ~GLuint(0);
+
+    GLuint currentProgram;
+    GLenum currentPolygonMode;
+    GLuint currentVertexArray;
+    GlCallStats stats;
+
+    GlState() : currentProgram(0), currentPolygonMode(GL_FILL), currentVertexArray(0), stats{0, 0, 0} {}
+};
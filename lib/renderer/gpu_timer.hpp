@@ -0,0 +1,70 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+#include "gl_handle.hpp"
+
+// Queries in flight; results are read a few frames late so that reading
+// them never waits for the GPU.
+#ifndef GPU_TIMER_QUERIES
+    #define GPU_TIMER_QUERIES 4
+#endif
+
+// GPU time spent between begin() and end(), from GL_TIME_ELAPSED queries.
+// Each end() collects whichever earlier queries have finished, so
+// getMillis() trails the current frame by up to GPU_TIMER_QUERIES frames.
+// Timers cannot be nested, as only one GL_TIME_ELAPSED query may be active.
+class GpuTimer {
+public:
+    GpuTimer() : next(0), pending(0), lastMillis(0.0), totalMillis(0.0), samples(0) {
+        for (QueryHandle& query : queries) query = makeQuery();
+    }
+
+    void begin() {
+        // All queries still busy: drop the oldest rather than stall.
+        if (pending == GPU_TIMER_QUERIES) --pending;
+        glBeginQuery(GL_TIME_ELAPSED, queries[next].get());
+    }
+
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+        next = (next + 1) % GPU_TIMER_QUERIES;
+        ++pending;
+        collect();
+    }
+
+    double getMillis() const { return lastMillis; }
+    double getAverageMillis() const { return samples ? totalMillis / double(samples) : 0.0; }
+    size_t getSamples() const { return samples; }
+
+    void resetAverage() {
+        totalMillis = 0.0;
+        samples = 0;
+    }
+
+private:
+    QueryHandle queries[GPU_TIMER_QUERIES];
+    unsigned int next;
+    unsigned int pending;
+    double lastMillis;
+    double totalMillis;
+    size_t samples;
+
+    void collect() {
+        while (pending > 0) {
+            unsigned int oldest = (next + GPU_TIMER_QUERIES - pending) % GPU_TIMER_QUERIES;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[oldest].get(), GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[oldest].get(), GL_QUERY_RESULT, &nanoseconds);
+            lastMillis = double(nanoseconds) * 1e-6;
+            totalMillis += lastMillis;
+            ++samples;
+            --pending;
+        }
+    }
+};
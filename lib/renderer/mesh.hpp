@@ -16,6 +16,8 @@
 #include <algorithm>
 
 #include "shader.hpp"
+#include "gl_handle.hpp"
+#include "gl_state.hpp"
 
 #define VERTEX_WIDTH 8
 
@@ -39,6 +41,7 @@ public:
     glm::vec3 up;
 
     glm::mat4 model;
+    glm::mat3 normalMatrix;
 
     Mesh(float _vertices[], unsigned int _vertexCount, unsigned int _indices[], unsigned int _indexCount)
         : position(glm::vec3(0.0f)), rotation(glm::vec3(0.0f)), scale(glm::vec3(1.0f)), color(glm::vec4(1.0f)), cachedModelCount(0)
@@ -80,11 +83,9 @@ public:
     Mesh(const char *model_file, const glm::vec3& _position, const glm::vec3& _rotation, const glm::vec4& _scale)
         : Mesh(model_file, _position, _rotation, _scale, glm::vec4(1.0f)) {}
 
-    ~Mesh() {
-        glDeleteVertexArrays(1, &vao);
-        glDeleteBuffers(1, &vbo);
-        glDeleteBuffers(1, &ibo);
-    }
+    // GL objects are owned, so a Mesh can be moved but not copied.
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
 
     void translate(const glm::vec3& delta) {
         position += delta;
@@ -191,7 +192,7 @@ public:
             vertices[i + 7] = -vertices[i + 7];
         }
 
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo.get());
         glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
     }
 
@@ -221,57 +222,78 @@ public:
         return glm::vec3(model * glm::vec4(localPos, 1.0f));
     }
 
-    void render(Shader shader, int mode = GL_FILL) {
-        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    void render(Shader& shader, int mode = GL_FILL) {
+        GlState& state = GlState::get();
+        state.polygonMode(mode);
         shader.bind();
-        shader.setUniform4f("objectColor", color);
-        shader.setUniformMat4f("models[0]", model);
-        glBindVertexArray(vao);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
-        glBindVertexArray(0);
+        resolveUniforms(shader);
+        shader.set(uniforms.objectColor, color);
+        shader.set(uniforms.models, model);
+        shader.set(uniforms.normalMatrices, normalMatrix);
+        state.bindVertexArray(vao.get());
+        state.drawElements(indices.size());
     }
 
     void renderInstanced(Shader& shader, const std::vector<glm::mat4>& models, int mode = GL_FILL) {
         if (models.size() != cachedModelCount) {
             setInstanceModels(models);
-            cacheUniformLocations(shader);
             cachedModelCount = models.size();
         }
 
-        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        GlState& state = GlState::get();
+        state.polygonMode(mode);
         shader.bind();
-        glBindVertexArray(vao);
-        shader.setUniform4f("objectColor", color);
-        for (const auto& chunkModels : splitModels) {
-            shader.setUniformMat4fv("models", &chunkModels[0], chunkModels.size());
-            glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr, chunkModels.size());
+        state.bindVertexArray(vao.get());
+        resolveUniforms(shader);
+        shader.set(uniforms.objectColor, color);
+        for (size_t c = 0; c < splitModels.size(); ++c) {
+            const auto& chunkModels = splitModels[c];
+            shader.set(uniforms.models, &chunkModels[0], chunkModels.size());
+            shader.set(uniforms.normalMatrices, &splitNormals[c][0], chunkModels.size());
+            state.drawElementsInstanced(indices.size(), chunkModels.size());
         }
-        glBindVertexArray(0);
     }
 
 protected:
-    unsigned int vao, vbo, ibo;
+    VertexArrayHandle vao;
+    BufferHandle vbo, ibo;
 
     std::vector<std::vector<glm::mat4>> splitModels;
+    std::vector<std::vector<glm::mat3>> splitNormals;
     unsigned int cachedModelCount;
-    std::vector<std::string> uniformLocations;
+
+    // Handles for the last shader drawn with; re-resolved only when the
+    // program changes.
+    struct MeshUniforms {
+        unsigned int program = 0;
+        Uniform<glm::vec4> objectColor;
+        Uniform<glm::mat4> models;
+        Uniform<glm::mat3> normalMatrices;
+    } uniforms;
+
+    void resolveUniforms(const Shader& shader) {
+        if (uniforms.program == shader.getProgram()) return;
+        uniforms.program = shader.getProgram();
+        uniforms.objectColor = shader.uniform<glm::vec4>("objectColor");
+        uniforms.models = shader.uniform<glm::mat4>("models");
+        uniforms.normalMatrices = shader.uniform<glm::mat3>("normalMatrices");
+    }
 
     void setInstanceModels(const std::vector<glm::mat4>& models) {
         splitModels.clear();
         splitModels.reserve((models.size() + INSTANCE_COUNT - 1) / INSTANCE_COUNT);
+        splitNormals.clear();
+        splitNormals.reserve(splitModels.capacity());
 
         for (std::size_t i = 0; i < models.size(); i += INSTANCE_COUNT) {
             auto last = std::min(models.size(), i + INSTANCE_COUNT);
             splitModels.emplace_back(models.begin() + i, models.begin() + last);
+            splitNormals.emplace_back();
+            for (const glm::mat4& m : splitModels.back())
+                splitNormals.back().push_back(glm::transpose(glm::inverse(glm::mat3(m))));
         }
     }
 
-    void cacheUniformLocations(Shader shader) {
-        uniformLocations.resize(INSTANCE_COUNT);
-        for (int i = 0; i < INSTANCE_COUNT; i++)
-            uniformLocations[i] = "models[" + std::to_string(i) + "]";
-    }
-
     void updateDirectionVectors() {
         glm::vec3 localFront = glm::vec3(0.0f, 0.0f, -1.0f);
         glm::vec3 localUp    = glm::vec3(0.0f, 1.0f,  0.0f);
@@ -298,6 +320,12 @@ protected:
         model *= glm::toMat4(rotation);
         model = glm::scale(model, scale);
         model = glm::translate(model, -origin);
+
+        // Inverse transpose of rotation * scale.
+        normalMatrix = glm::mat3_cast(rotation);
+        normalMatrix[0] /= scale.x;
+        normalMatrix[1] /= scale.y;
+        normalMatrix[2] /= scale.z;
     }
 
     void parseOBJ(const char* path) {
@@ -371,15 +399,15 @@ protected:
     }
 
     void generateBuffers() {
-        glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
+        vao = makeVertexArray();
+        GlState::get().bindVertexArray(vao.get());
 
-        glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        vbo = makeBuffer();
+        glBindBuffer(GL_ARRAY_BUFFER, vbo.get());
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
 
-        glGenBuffers(1, &ibo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        ibo = makeBuffer();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo.get());
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
         glEnableVertexAttribArray(0);
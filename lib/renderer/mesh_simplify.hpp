@@ -0,0 +1,309 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include "mapped_file.hpp"
+
+// Mesh::vertices layout: position, texcoord, normal.
+#ifndef VERTEX_WIDTH
+    #define VERTEX_WIDTH 8
+#endif
+
+// Bumped whenever simplifyMesh changes its output, so old caches are rebuilt.
+#define MESH_LOD_MAGIC 0x32444f4cu     // "LOD2"
+
+// Weight of the planes that pin open borders in place, relative to the
+// face planes.
+#ifndef MESH_SIMPLIFY_BORDER_WEIGHT
+    #define MESH_SIMPLIFY_BORDER_WEIGHT 100.0
+#endif
+
+// Quadric error metric (Garland and Heckbert): the sum of squared distances
+// to a set of planes, as a symmetric 4x4 matrix stored by its 10 entries.
+struct Quadric {
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    static Quadric zero() { return {0, 0, 0, 0, 0, 0, 0, 0, 0, 0}; }
+
+    static Quadric plane(const glm::dvec3& n, double d, double weight) {
+        return {weight * n.x * n.x, weight * n.x * n.y, weight * n.x * n.z, weight * n.x * d,
+                weight * n.y * n.y, weight * n.y * n.z, weight * n.y * d,
+                weight * n.z * n.z, weight * n.z * d, weight * d * d};
+    }
+
+    Quadric& operator+=(const Quadric& q) {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+        bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        return *this;
+    }
+
+    double error(const glm::dvec3& v) const {
+        return a2 * v.x * v.x + 2.0 * ab * v.x * v.y + 2.0 * ac * v.x * v.z + 2.0 * ad * v.x
+             + b2 * v.y * v.y + 2.0 * bc * v.y * v.z + 2.0 * bd * v.y
+             + c2 * v.z * v.z + 2.0 * cd * v.z + d2;
+    }
+};
+
+// Edge-collapse simplification of a Mesh-layout triangle list down to about
+// `targetTriangles`. Corners are first welded by position, since OBJ
+// import gives every face corner its own vertex. Edges are collapsed
+// cheapest first (to whichever of the two endpoints or their midpoint has
+// the least quadric error), skipping collapses that would flip a face.
+// The output is again one vertex per corner, with face normals and the
+// texcoords of the surviving welded vertex.
+inline void simplifyMesh(const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                         size_t targetTriangles, std::vector<float>& outVertices, std::vector<unsigned int>& outIndices) {
+    struct Key {
+        float x, y, z;
+        bool operator==(const Key& o) const { return x == o.x && y == o.y && z == o.z; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            uint32_t b[3];
+            std::memcpy(b, &k, sizeof(b));
+            return size_t(b[0] * 73856093u ^ b[1] * 19349663u ^ b[2] * 83492791u);
+        }
+    };
+
+    // Weld.
+    std::unordered_map<Key, uint32_t, KeyHash> welded;
+    std::vector<glm::dvec3> pos;
+    std::vector<glm::vec2> uv;
+    std::vector<uint32_t> corner(indices.size());
+    for (size_t k = 0; k < indices.size(); ++k) {
+        const float* v = &vertices[size_t(indices[k]) * VERTEX_WIDTH];
+        auto found = welded.emplace(Key{v[0], v[1], v[2]}, uint32_t(pos.size()));
+        if (found.second) {
+            pos.emplace_back(v[0], v[1], v[2]);
+            uv.emplace_back(v[3], v[4]);
+        }
+        corner[k] = found.first->second;
+    }
+
+    size_t triCount = corner.size() / 3;
+    std::vector<uint8_t> triAlive(triCount, 1);
+    std::vector<std::vector<uint32_t>> vertexTris(pos.size());
+    std::vector<Quadric> quadric(pos.size(), Quadric::zero());
+    size_t alive = 0;
+
+    auto faceNormal = [&](uint32_t t, glm::dvec3& n) {
+        const uint32_t* c = &corner[t * 3];
+        n = glm::cross(pos[c[1]] - pos[c[0]], pos[c[2]] - pos[c[0]]);
+        return glm::length(n);
+    };
+
+    for (uint32_t t = 0; t < triCount; ++t) {
+        const uint32_t* c = &corner[t * 3];
+        if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2]) {
+            triAlive[t] = 0;
+            continue;
+        }
+        ++alive;
+        glm::dvec3 n;
+        double area = faceNormal(t, n);
+        if (area > 0.0) n /= area;
+        for (int k = 0; k < 3; ++k) {
+            vertexTris[c[k]].push_back(t);
+            quadric[c[k]] += Quadric::plane(n, -glm::dot(n, pos[c[0]]), 0.5 * area);
+        }
+    }
+
+    // Edges used by exactly one live triangle lie on an open border; a plane
+    // through the edge, perpendicular to the face, keeps it from moving.
+    std::unordered_map<uint64_t, int> edgeUse;
+    auto edgeKey = [](uint32_t a, uint32_t b) { return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a; };
+    for (uint32_t t = 0; t < triCount; ++t)
+        if (triAlive[t])
+            for (int k = 0; k < 3; ++k) ++edgeUse[edgeKey(corner[t * 3 + k], corner[t * 3 + (k + 1) % 3])];
+    for (uint32_t t = 0; t < triCount; ++t) {
+        if (!triAlive[t]) continue;
+        glm::dvec3 n;
+        if (faceNormal(t, n) <= 0.0) continue;
+        n = glm::normalize(n);
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = corner[t * 3 + k], b = corner[t * 3 + (k + 1) % 3];
+            if (edgeUse[edgeKey(a, b)] != 1) continue;
+            glm::dvec3 edge = pos[b] - pos[a];
+            glm::dvec3 side = glm::cross(edge, n);
+            double length = glm::length(side);
+            if (length <= 0.0) continue;
+            side /= length;
+            Quadric border = Quadric::plane(side, -glm::dot(side, pos[a]), MESH_SIMPLIFY_BORDER_WEIGHT * glm::dot(edge, edge));
+            quadric[a] += border;
+            quadric[b] += border;
+        }
+    }
+
+    struct Collapse {
+        double cost;
+        uint32_t a, b;
+        uint32_t versionA, versionB;
+        glm::dvec3 target;
+        bool operator<(const Collapse& o) const { return cost > o.cost; }
+    };
+    std::vector<uint32_t> version(pos.size(), 0);
+    std::vector<uint32_t> remap(pos.size());
+    for (uint32_t v = 0; v < remap.size(); ++v) remap[v] = v;
+    std::vector<Collapse> heap;
+
+    auto push = [&](uint32_t a, uint32_t b) {
+        Quadric q = quadric[a];
+        q += quadric[b];
+        glm::dvec3 options[3] = {pos[a], pos[b], 0.5 * (pos[a] + pos[b])};
+        Collapse c{q.error(options[0]), a, b, version[a], version[b], options[0]};
+        for (int k = 1; k < 3; ++k) {
+            double e = q.error(options[k]);
+            if (e < c.cost) {
+                c.cost = e;
+                c.target = options[k];
+            }
+        }
+        heap.push_back(c);
+        std::push_heap(heap.begin(), heap.end());
+    };
+
+    for (auto& edge : edgeUse) push(uint32_t(edge.first >> 32), uint32_t(edge.first & 0xffffffffu));
+
+    // Whether moving `v` to `target` keeps every surviving face around it
+    // (other than those shared with `other`, which disappear) facing the
+    // same way.
+    auto keepsOrientation = [&](uint32_t v, uint32_t other, const glm::dvec3& target) {
+        for (uint32_t t : vertexTris[v]) {
+            if (!triAlive[t]) continue;
+            const uint32_t* c = &corner[t * 3];
+            if (c[0] == other || c[1] == other || c[2] == other) continue;
+            glm::dvec3 before, p[3];
+            faceNormal(t, before);
+            for (int k = 0; k < 3; ++k) p[k] = c[k] == v ? target : pos[c[k]];
+            glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+            if (glm::dot(before, after) <= 0.2 * glm::length(before) * glm::length(after)) return false;
+        }
+        return true;
+    };
+
+    while (alive > targetTriangles && !heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end());
+        Collapse c = heap.back();
+        heap.pop_back();
+        if (remap[c.a] != c.a || remap[c.b] != c.b) continue;
+        if (version[c.a] != c.versionA || version[c.b] != c.versionB) continue;
+        if (!keepsOrientation(c.a, c.b, c.target) || !keepsOrientation(c.b, c.a, c.target)) continue;
+
+        // Merge b into a.
+        pos[c.a] = c.target;
+        quadric[c.a] += quadric[c.b];
+        remap[c.b] = c.a;
+        for (uint32_t t : vertexTris[c.b]) {
+            if (!triAlive[t]) continue;
+            uint32_t* tc = &corner[t * 3];
+            for (int k = 0; k < 3; ++k)
+                if (tc[k] == c.b) tc[k] = c.a;
+            if (tc[0] == tc[1] || tc[1] == tc[2] || tc[0] == tc[2]) {
+                triAlive[t] = 0;
+                --alive;
+            } else {
+                vertexTris[c.a].push_back(t);
+            }
+        }
+        vertexTris[c.b].clear();
+
+        // Drop dead faces from a's list and requeue its edges.
+        std::vector<uint32_t>& around = vertexTris[c.a];
+        around.erase(std::remove_if(around.begin(), around.end(), [&](uint32_t t) { return !triAlive[t]; }), around.end());
+        ++version[c.a];
+        std::vector<uint32_t> neighbours;
+        for (uint32_t t : around)
+            for (int k = 0; k < 3; ++k)
+                if (corner[t * 3 + k] != c.a) neighbours.push_back(corner[t * 3 + k]);
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (uint32_t n : neighbours) push(c.a, n);
+    }
+
+    outVertices.clear();
+    outIndices.clear();
+    for (uint32_t t = 0; t < triCount; ++t) {
+        if (!triAlive[t]) continue;
+        glm::dvec3 n;
+        double area = faceNormal(t, n);
+        glm::vec3 normal = area > 0.0 ? glm::vec3(n / area) : glm::vec3(0.0f, 1.0f, 0.0f);
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = corner[t * 3 + k];
+            float out[VERTEX_WIDTH] = {float(pos[v].x), float(pos[v].y), float(pos[v].z), uv[v].x, uv[v].y,
+                                       normal.x, normal.y, normal.z};
+            outIndices.push_back(unsigned(outVertices.size() / VERTEX_WIDTH));
+            outVertices.insert(outVertices.end(), out, out + VERTEX_WIDTH);
+        }
+    }
+}
+
+// FNV-1a over the source geometry, so a cached LOD is rebuilt whenever the
+// mesh it came from changes.
+inline uint64_t meshHash(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&](const void* data, size_t bytes) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t k = 0; k < bytes; ++k) h = (h ^ p[k]) * 1099511628211ull;
+    };
+    mix(vertices.data(), vertices.size() * sizeof(float));
+    mix(indices.data(), indices.size() * sizeof(unsigned int));
+    return h;
+}
+
+// Simplified copy of a mesh at `ratio` of its triangles, cached in
+// `cachePath` (e.g. next to the OBJ it was imported from): a valid cache
+// for the same source and ratio is read back, anything else is rebuilt and
+// rewritten. A cache that cannot be written only costs the rebuild.
+inline void loadOrSimplifyMesh(const std::string& cachePath, const std::vector<float>& vertices,
+                               const std::vector<unsigned int>& indices, float ratio,
+                               std::vector<float>& outVertices, std::vector<unsigned int>& outIndices) {
+    struct Header {
+        uint32_t magic;
+        uint32_t target;
+        uint64_t source;
+        uint64_t vertexFloats;
+        uint64_t indexCount;
+    };
+
+    size_t target = std::max<size_t>(size_t(double(indices.size() / 3) * ratio), 1);
+    uint64_t source = meshHash(vertices, indices);
+
+    if (std::ifstream(cachePath).good()) {
+        MappedFile file;
+        if (file.open(cachePath) && file.getSize() >= sizeof(Header)) {
+            Header h;
+            std::memcpy(&h, file.getData(), sizeof(Header));
+            if (h.magic == MESH_LOD_MAGIC && h.target == target && h.source == source &&
+                file.getSize() == sizeof(Header) + h.vertexFloats * sizeof(float) + h.indexCount * sizeof(unsigned int)) {
+                const uint8_t* data = file.getData() + sizeof(Header);
+                outVertices.resize(h.vertexFloats);
+                outIndices.resize(h.indexCount);
+                std::memcpy(outVertices.data(), data, h.vertexFloats * sizeof(float));
+                std::memcpy(outIndices.data(), data + h.vertexFloats * sizeof(float), h.indexCount * sizeof(unsigned int));
+                return;
+            }
+        }
+    }
+
+    simplifyMesh(vertices, indices, target, outVertices, outIndices);
+
+    std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write LOD cache: " << cachePath << "\n";
+        return;
+    }
+    Header h{MESH_LOD_MAGIC, uint32_t(target), source, outVertices.size(), outIndices.size()};
+    file.write(reinterpret_cast<const char*>(&h), sizeof(Header));
+    file.write(reinterpret_cast<const char*>(outVertices.data()), std::streamsize(outVertices.size() * sizeof(float)));
+    file.write(reinterpret_cast<const char*>(outIndices.data()), std::streamsize(outIndices.size() * sizeof(unsigned int)));
+}
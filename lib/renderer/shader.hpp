@@ -9,43 +9,76 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <type_traits>
+#include <algorithm>
+
+#include "gl_handle.hpp"
+#include "gl_state.hpp"
+
+// Location of a uniform of GLSL type T, resolved once by Shader::uniform<T>()
+// so setting it is a plain integer call with no name lookup. Locations
+// belong to one program.
+template <typename T>
+struct Uniform {
+    int location = -1;
+
+    bool isValid() const { return location != -1; }
+};
+
+template <typename T> struct UniformType;
+template <> struct UniformType<int>       { static constexpr GLenum value = GL_INT; };
+template <> struct UniformType<float>     { static constexpr GLenum value = GL_FLOAT; };
+template <> struct UniformType<glm::vec2> { static constexpr GLenum value = GL_FLOAT_VEC2; };
+template <> struct UniformType<glm::vec3> { static constexpr GLenum value = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::vec4> { static constexpr GLenum value = GL_FLOAT_VEC4; };
+template <> struct UniformType<glm::ivec2> { static constexpr GLenum value = GL_INT_VEC2; };
+template <> struct UniformType<glm::ivec3> { static constexpr GLenum value = GL_INT_VEC3; };
+template <> struct UniformType<glm::ivec4> { static constexpr GLenum value = GL_INT_VEC4; };
+template <> struct UniformType<glm::mat2> { static constexpr GLenum value = GL_FLOAT_MAT2; };
+template <> struct UniformType<glm::mat3> { static constexpr GLenum value = GL_FLOAT_MAT3; };
+template <> struct UniformType<glm::mat4> { static constexpr GLenum value = GL_FLOAT_MAT4; };
 
 class Shader {
 public:
     Shader(const std::string& vertex, const std::string& fragment, const std::string& geometry = "", const std::string& compute = "") {
-        program = glCreateProgram();
+        program.reset(glCreateProgram());
         addShader(vertex, GL_VERTEX_SHADER);
         addShader(fragment, GL_FRAGMENT_SHADER);
         addShader(geometry, GL_GEOMETRY_SHADER);
         addShader(compute, GL_COMPUTE_SHADER);
         
-        glLinkProgram(program);
+        glLinkProgram(program.get());
 
         int success;
-        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        glGetProgramiv(program.get(), GL_LINK_STATUS, &success);
         if (!success) {
             char infoLog[512];
-            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            glGetProgramInfoLog(program.get(), 512, nullptr, infoLog);
             std::cout << "[!] Shader linking failed:\n" << infoLog << '\n';
             std::cin.get();
         }
+        else {
+            resolveUniforms();
+        }
 
-        glValidateProgram(program);
+        glValidateProgram(program.get());
     }
 
-    ~Shader() {
-        glDeleteProgram(program);
-    }
+    // Move-only: the program is deleted once, by the last owner.
+    Shader(Shader&&) = default;
+    Shader& operator=(Shader&&) = default;
 
     void addShader(const std::string& path, unsigned int type) {
         if (path.empty()) return;
         std::string source = readFile(path);
         const char *shaderSource = source.c_str();
-        unsigned int shader = glCreateShader(type);
-        glShaderSource(shader, 1, &shaderSource, nullptr);
-        glCompileShader(shader);
-        glAttachShader(program, shader);
-        if(!validateShader(shader, shaderSource, type))
+        // Attached shaders are only flagged by glDeleteShader, and freed
+        // with the program.
+        ShaderHandle shader(glCreateShader(type));
+        glShaderSource(shader.get(), 1, &shaderSource, nullptr);
+        glCompileShader(shader.get());
+        glAttachShader(program.get(), shader.get());
+        if(!validateShader(shader.get(), shaderSource, type))
             std::exit(-1);
     }
 
@@ -59,14 +92,67 @@ public:
             glGetShaderInfoLog(shader, length, &length, message);
             std::cout << "[!] Error: Failed to compile fragment shader!\n" << message;
             std::cout << "Source:\n" << shaderSource << "\n\n";
-            glDeleteShader(shader);
             std::cin.get();
         }
         return result;
     }
 
-    void bind()   { glUseProgram(program); }
-    void unbind() { glUseProgram(0);       }
+    void bind()   { GlState::get().useProgram(program.get()); }
+    void unbind() { GlState::get().useProgram(0);             }
+
+    unsigned int getProgram() const { return program.get(); }
+
+    // Points the program's uniform block `name` at a buffer binding point;
+    // GLSL 330 has no layout(binding) for blocks, so this is per program.
+    bool bindUniformBlock(const std::string& name, GLuint binding) {
+        GLuint index = glGetUniformBlockIndex(program.get(), name.c_str());
+        if (index == GL_INVALID_INDEX) {
+            std::cout << "Warning: uniform block '" << name << "' doesn't exist!\n";
+            return false;
+        }
+        glUniformBlockBinding(program.get(), index, binding);
+        return true;
+    }
+
+    // Handle for an active uniform; invalid (and ignored by set()) if the
+    // program has no such uniform or it is not of GLSL type T. Arrays are
+    // found by their bare name or as "name[0]"; integer uniforms also match
+    // samplers.
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const {
+        auto it = uniforms.find(name);
+        if (it == uniforms.end()) {
+            std::cout << "Warning: uniform '" << name << "' doesn't exist!\n";
+            return {};
+        }
+        if (it->second.type != UniformType<T>::value && !(std::is_same<T, int>::value && isSampler(it->second.type))) {
+            std::cerr << "Error: uniform '" << name << "' is not of the requested type.\n";
+            return {};
+        }
+        return {it->second.location};
+    }
+
+#pragma region handles
+    void set(Uniform<int> u, int value)                    { glUniform1i(u.location, value); }
+    void set(Uniform<float> u, float value)                { glUniform1f(u.location, value); }
+    void set(Uniform<glm::vec2> u, const glm::vec2& v)     { glUniform2fv(u.location, 1, &v[0]); }
+    void set(Uniform<glm::vec3> u, const glm::vec3& v)     { glUniform3fv(u.location, 1, &v[0]); }
+    void set(Uniform<glm::vec4> u, const glm::vec4& v)     { glUniform4fv(u.location, 1, &v[0]); }
+    void set(Uniform<glm::ivec2> u, const glm::ivec2& v)   { glUniform2iv(u.location, 1, &v[0]); }
+    void set(Uniform<glm::ivec3> u, const glm::ivec3& v)   { glUniform3iv(u.location, 1, &v[0]); }
+    void set(Uniform<glm::ivec4> u, const glm::ivec4& v)   { glUniform4iv(u.location, 1, &v[0]); }
+    void set(Uniform<glm::mat2> u, const glm::mat2& m)     { glUniformMatrix2fv(u.location, 1, GL_FALSE, &m[0][0]); }
+    void set(Uniform<glm::mat3> u, const glm::mat3& m)     { glUniformMatrix3fv(u.location, 1, GL_FALSE, &m[0][0]); }
+    void set(Uniform<glm::mat4> u, const glm::mat4& m)     { glUniformMatrix4fv(u.location, 1, GL_FALSE, &m[0][0]); }
+
+    // Consecutive elements of an array uniform, starting at the handle's.
+    void set(Uniform<glm::mat3> u, const glm::mat3* matrices, size_t count) {
+        glUniformMatrix3fv(u.location, static_cast<GLsizei>(count), GL_FALSE, &matrices[0][0][0]);
+    }
+    void set(Uniform<glm::mat4> u, const glm::mat4* matrices, size_t count) {
+        glUniformMatrix4fv(u.location, static_cast<GLsizei>(count), GL_FALSE, &matrices[0][0][0]);
+    }
+#pragma endregion handles
     
 #pragma region uniforms
     void setUniform1i(const std::string& name, int value) {
@@ -131,22 +217,63 @@ public:
     }
     
     int getUniformLocation(const std::string& name) {
-        if (uniformLocationCache.find(name) != uniformLocationCache.end())
-            return uniformLocationCache[name];
-    
-        int location = glGetUniformLocation(program, name.c_str());
-    
+        auto it = uniforms.find(name);
+        if (it != uniforms.end())
+            return it->second.location;
+
+        // Array elements other than the first are not listed at link time.
+        int location = glGetUniformLocation(program.get(), name.c_str());
+
         if (location == -1)
             std::cout<<"Warning: uniform '"<<name<<"' doesn't exist!\n";
-        
-        uniformLocationCache[name] = location;
+
+        uniforms[name] = {location, 0};
         return location;
     }
 #pragma endregion uniforms
 
 private:
-    unsigned int program;
-    std::unordered_map<std::string, int> uniformLocationCache;
+    struct UniformInfo {
+        int location;
+        GLenum type;
+    };
+
+    ProgramHandle program;
+    std::unordered_map<std::string, UniformInfo> uniforms;
+
+    // Records every active uniform once the program is linked.
+    void resolveUniforms() {
+        int count = 0, maxLength = 0;
+        glGetProgramiv(program.get(), GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program.get(), GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(std::max(maxLength, 1), '\0');
+
+        for (int i = 0; i < count; ++i) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program.get(), GLuint(i), GLsizei(name.size()), &length, &size, &type, &name[0]);
+            std::string uniformName(name.data(), size_t(length));
+            int location = glGetUniformLocation(program.get(), uniformName.c_str());
+            if (location == -1) continue;   // block members
+
+            uniforms[uniformName] = {location, type};
+            size_t bracket = uniformName.rfind("[0]");
+            if (bracket != std::string::npos && bracket + 3 == uniformName.size())
+                uniforms[uniformName.substr(0, bracket)] = {location, type};
+        }
+    }
+
+    static bool isSampler(GLenum type) {
+        switch (type) {
+            case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_BUFFER:
+            case GL_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D:
+                return true;
+            default:
+                return false;
+        }
+    }
 
     std::string readFile(const std::string& path) {
         std::ifstream file(path.c_str(), std::ios_base::binary);
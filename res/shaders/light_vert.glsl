@@ -4,17 +4,27 @@ layout(location = 0) in vec3 positionVert;
 layout(location = 1) in vec3 textureVert;
 layout(location = 2) in vec3 normalVert;
 
+layout(std140) uniform FrameUniforms {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
+// Normal matrices are the inverse transpose of each model's upper 3x3,
+// computed on the CPU alongside the model matrices.
 uniform mat4 models[128];
-uniform mat4 view;
-uniform mat4 proj;
+uniform mat3 normalMatrices[128];
 
 out vec3 v_normal;
 out vec3 v_fragPos;
 
 void main()
 {
-    mat4 model = models[gl_InstanceID];
-    gl_Position = vec4(positionVert, 1.0) * transpose(model) * transpose(view) * proj;
-    v_fragPos = vec3(vec4(positionVert + vec3(0.0, 0.0, 50.0), 1.0) * transpose(model));
-    v_normal = normalVert * mat3(inverse(model));
+    vec4 worldPos = models[gl_InstanceID] * vec4(positionVert, 1.0);
+    gl_Position = viewProj * worldPos;
+    v_fragPos = worldPos.xyz;
+    v_normal = normalMatrices[gl_InstanceID] * normalVert;
 }
\ No newline at end of file
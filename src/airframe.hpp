@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+#include "philox.hpp"
+
+#define AIRFRAME_STREAM 0x41524600u
+
+// Physical parameters of one airframe. The defaults are the values Drone
+// and Propeller used to hard-code.
+struct AirframeParams {
+    float mass = 0.064f;
+    glm::vec3 inertia = glm::vec3(0.0f);
+    float maxThrust = 24.0f;
+    float spinTorqueScale = 0.1f;
+    float motorResponse = 5.0f;     // 1 / motor time constant, per second
+    float linearDamping = 0.98f;    // velocity retained per step
+};
+
+// Solid-sphere inertia about the largest half-extent, as Drone computes it.
+inline glm::vec3 airframeInertia(float mass, const glm::vec3& halfExtents) {
+    float radius = glm::max(glm::max(halfExtents.x, halfExtents.y), halfExtents.z);
+    return glm::vec3(0.4f * mass * radius * radius);
+}
+
+inline AirframeParams defaultAirframe(const glm::vec3& halfExtents, float mass = 0.064f) {
+    AirframeParams params;
+    params.mass = mass;
+    params.inertia = airframeInertia(mass, halfExtents);
+    return params;
+}
+
+// Uniform multiplicative range applied to a nominal value.
+struct ParameterRange {
+    float min = 1.0f;
+    float max = 1.0f;
+
+    float sample(float u) const { return min + (max - min) * u; }
+};
+
+// Scale ranges for domain randomisation. Inertia follows the sampled mass
+// before its own scale is applied, and drag scales the fraction of velocity
+// lost per step (1 - linearDamping) rather than the damping factor. Draws
+// are Philox keyed by (seed, drone) and counted by episode, so a given drone
+// and episode always get the same airframe regardless of threading.
+struct AirframeRandomization {
+    ParameterRange mass;
+    ParameterRange inertia;
+    ParameterRange maxThrust;
+    ParameterRange spinTorqueScale;
+    ParameterRange motorResponse;
+    ParameterRange drag;
+    uint32_t seed = 1;
+
+    bool enabled() const {
+        const ParameterRange* ranges[] = {&mass, &inertia, &maxThrust, &spinTorqueScale, &motorResponse, &drag};
+        for (const ParameterRange* r : ranges)
+            if (r->min != 1.0f || r->max != 1.0f) return true;
+        return false;
+    }
+
+    AirframeParams sample(const AirframeParams& nominal, uint32_t drone, uint32_t episode) const {
+        uint32_t key[2] = {seed, drone};
+        uint32_t bits[8];
+        uint32_t c0[4] = {episode * 2u, AIRFRAME_STREAM, 0u, 0u};
+        uint32_t c1[4] = {episode * 2u + 1u, AIRFRAME_STREAM, 0u, 0u};
+        Philox4x32::generate(c0, key, bits);
+        Philox4x32::generate(c1, key, bits + 4);
+
+        AirframeParams out;
+        out.mass = nominal.mass * mass.sample(philoxUniform(bits[0]));
+        out.inertia = nominal.inertia * (out.mass / nominal.mass) * inertia.sample(philoxUniform(bits[1]));
+        out.maxThrust = nominal.maxThrust * maxThrust.sample(philoxUniform(bits[2]));
+        out.spinTorqueScale = nominal.spinTorqueScale * spinTorqueScale.sample(philoxUniform(bits[3]));
+        out.motorResponse = nominal.motorResponse * motorResponse.sample(philoxUniform(bits[4]));
+        out.linearDamping = 1.0f - (1.0f - nominal.linearDamping) * drag.sample(philoxUniform(bits[5]));
+        return out;
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include "spatial_grid.hpp"
+#include "thread_pool.hpp"
+#include "swarm.hpp"
+
+struct DownwashConfig {
+    float radius = 60.0f;        // neighbours further than this are ignored
+    float rotorRadius = 9.0f;    // jet radius at the rotor plane
+    float spread = 0.2f;         // jet radius growth per unit distance below
+    float strength = 0.6f;       // thrust loss directly under a full-thrust drone
+    float maxLoss = 0.8f;
+};
+
+struct DownwashStats {
+    size_t pairsTested;
+    double seconds;
+};
+
+// Thrust loss from the wakes of drones overhead. Each drone's wake is a jet
+// along its -up axis whose radius widens and whose centreline velocity
+// decays with distance below it, scaled by sqrt(thrust) as in momentum
+// theory; the lateral profile is 1 / (1 + (r / jetRadius)^2)^2, a bell
+// shape that needs no exp. Neighbours come from a SpatialGrid rebuilt every
+// call, searching only the half-space above each drone (wakes of drones
+// tilted past the horizontal are ignored), so the cost is O(N * k) for k
+// drones within `radius`. The result is written to Swarm::thrustScale.
+class DownwashModel {
+public:
+    DownwashConfig config;
+
+    DownwashModel(const glm::vec3& worldMin, const glm::vec3& worldMax, const DownwashConfig& _config = DownwashConfig())
+        : config(_config), grid(0.5f * _config.radius, worldMin, worldMax), stats{0, 0.0} {}
+
+    const DownwashStats& getStats() const { return stats; }
+
+    void apply(Swarm& swarm, ThreadPool* pool = nullptr) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        size_t count = swarm.size();
+
+        wakes.resize(count);
+        grid.clear();
+        for (size_t j = 0; j < count; ++j) {
+            grid.insertObstacle(int(j), swarm.position[j]);
+            const glm::vec4& t = swarm.thrust[j];
+            wakes[j].position = swarm.position[j];
+            wakes[j].down = swarm.rotation[j] * glm::vec3(0.0f, -1.0f, 0.0f);
+            wakes[j].strength = config.strength * std::sqrt(0.25f * (t.x + t.y + t.z + t.w));
+        }
+
+        unsigned int workers = pool ? pool->size() : 1;
+        pairs.assign(workers, 0);
+
+        auto range = [&](size_t begin, size_t end, unsigned int worker) {
+            size_t tested = 0;
+            for (size_t i = begin; i < end; ++i)
+                swarm.thrustScale[i] = 1.0f - lossAt(i, tested);
+            pairs[worker] += tested;
+        };
+
+        if (pool) pool->parallelFor(count, range, 128);
+        else range(0, count, 0);
+
+        stats.pairsTested = 0;
+        for (size_t p : pairs) stats.pairsTested += p;
+        stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - T0).count();
+    }
+
+private:
+    // Everything the inner loop reads about a neighbour, in one cache line.
+    struct alignas(32) Wake {
+        glm::vec3 position;
+        float strength;
+        glm::vec3 down;
+    };
+
+    SpatialGrid grid;
+    std::vector<Wake> wakes;
+    std::vector<size_t> pairs;
+    DownwashStats stats;
+
+    float lossAt(size_t i, size_t& tested) const {
+        const glm::vec3 p = wakes[i].position;
+        const glm::vec3 r(config.radius);
+        const float radius2 = config.radius * config.radius;
+        float loss = 0.0f;
+
+        // Branch-free: rejected candidates contribute zero, so the loop does
+        // not stall on unpredictable above/below tests.
+        grid.forEachInBox(p - glm::vec3(r.x, 0.0f, r.z), p + r, [&](int j) {
+            const Wake& w = wakes[j];
+            glm::vec3 d = p - w.position;
+            float dist2 = glm::dot(d, d);
+            float axial = glm::dot(d, w.down);
+            bool inside = size_t(j) != i && dist2 <= radius2 && axial > 0.0f;
+            axial = axial > 0.0f ? axial : 0.0f;
+
+            float invJet = 1.0f / (config.rotorRadius + config.spread * axial);
+            float decay = config.rotorRadius * invJet;
+            float x = (dist2 - axial * axial) * invJet * invJet;
+            float profile = 1.0f / (1.0f + x);
+            loss += inside ? w.strength * decay * decay * profile * profile : 0.0f;
+            ++tested;
+        });
+        return std::min(loss, config.maxLoss);
+    }
+};
+
+// Applies downwash `steps` times to `count` hovering drones on a jittered
+// lattice at constant density (one drone per `spacing`^3) and returns the
+// mean seconds per apply(). With constant density the neighbour count k is
+// fixed, so this should grow linearly in `count`.
+inline double benchmarkDownwash(size_t count, size_t steps = 30, float spacing = 25.0f, ThreadPool* pool = nullptr,
+                                double* averageNeighbours = nullptr) {
+    int side = std::max(1, int(std::ceil(std::cbrt(double(count)))));
+    glm::vec3 extent(float(side) * spacing);
+
+    Swarm swarm(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 cell(float(i % side), float((i / side) % side), float(i / (size_t(side) * side)));
+        glm::vec3 jitter(float((i * 7919) % 13) - 6.0f, 0.0f, float((i * 104729) % 11) - 5.0f);
+        swarm.reset(i, (cell + 0.5f) * spacing + jitter);
+        swarm.thrust[i] = glm::vec4(0.26f);
+    }
+
+    DownwashModel model(glm::vec3(-spacing), extent + spacing);
+    double seconds = 0.0;
+    size_t pairs = 0;
+    for (size_t s = 0; s < steps; ++s) {
+        model.apply(swarm, pool);
+        seconds += model.getStats().seconds;
+        pairs += model.getStats().pairsTested;
+    }
+
+    if (averageNeighbours)
+        *averageNeighbours = double(pairs) / double(steps * count);
+    return seconds / double(steps);
+}
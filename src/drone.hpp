@@ -4,6 +4,30 @@
 #include "box_collider.hpp"
 
 #include "propeller.hpp"
+#include "airframe.hpp"
+#include "frustum.hpp"
+#include "mesh_simplify.hpp"
+
+// Spinning blades reach past the drone mesh bounds by up to their radius
+// (8.47 model units at the 0.75 propeller scale).
+#ifndef DRONE_CULL_MARGIN
+    #define DRONE_CULL_MARGIN 6.4f
+#endif
+
+// Level 0 is the full mesh; beyond DRONE_LOD_DISTANCE_1 the body is drawn
+// simplified, and beyond DRONE_LOD_DISTANCE_2 it is simplified further and
+// the propellers are left out.
+#define DRONE_LOD_COUNT 3
+
+#ifndef DRONE_LOD_DISTANCE_1
+    #define DRONE_LOD_DISTANCE_1 150.0f
+#endif
+
+#ifndef DRONE_LOD_DISTANCE_2
+    #define DRONE_LOD_DISTANCE_2 400.0f
+#endif
+
+#define DRONE_MODEL_PATH "../res/models/drone.obj"
 
 class Drone {
 public:
@@ -16,35 +40,45 @@ public:
     glm::quat angularVelocity;
 
     glm::vec3 inertia;
+    float maxThrust;
+    float spinTorqueScale;
+    float linearDamping;
 
     Drone(const glm::vec3& _position, const glm::quat _rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
           const glm::vec3 _color = glm::vec3(0.6f, 0.6f, 0.65f), float _mass = 0.064f, float _gravity = 9.807f)
         : position(_position), rotation(_rotation), mass(_mass), gravity(_gravity)
     {
-        mesh = std::make_unique<Mesh>("../res/models/drone.obj");
+        mesh = std::make_unique<Mesh>(DRONE_MODEL_PATH);
         mesh->setPosition(_position);
         mesh->setRotation(_rotation);
         mesh->setColor(_color);
         collider = std::make_unique<BoxCollider>(*mesh);
+        initLods(_color);
 
         velocity = glm::vec3(0.0f);
         angularVelocity = glm::quat(glm::vec4(0.0f));
 
         glm::vec3 halfExtents = (collider->max - collider->min) * 0.5f;
-        float radius = glm::compMax(halfExtents);
-        float I = 0.4f * mass * radius * radius;
-        inertia = glm::vec3(I);
-
         initPropellers();
+        setAirframe(defaultAirframe(halfExtents, mass));
     }
 
-    void update(float deltaTime) {
+    void setAirframe(const AirframeParams& params) {
+        mass = params.mass;
+        inertia = params.inertia;
+        maxThrust = params.maxThrust;
+        spinTorqueScale = params.spinTorqueScale;
+        linearDamping = params.linearDamping;
+        for (auto& prop : propellers)
+            prop->motorResponse = params.motorResponse;
+    }
+
+    // `wind` is the air velocity at the drone; damping acts on the velocity
+    // relative to it, so the drone is dragged towards the wind.
+    void update(float deltaTime, const glm::vec3& wind = glm::vec3(0.0f)) {
         glm::vec3 netForce(0.0f);
         glm::vec3 netTorque(0.0f);
 
-        const float maxThrust = 24.0f;
-        const float spinTorqueScale = 0.1f;
-
         for (auto& prop : propellers) {
             glm::vec3 relPos = prop->mesh->position - mesh->position;
             float t = prop->thrust * maxThrust;
@@ -52,14 +86,14 @@ public:
             
             netForce += force;
             netTorque += glm::cross(relPos, force);
-            netTorque.y += (prop->type == PROPELLER_TYPE_CW ? -1.0f : 1.0f) * prop->thrust * spinTorqueScale;
+            netTorque.y += (prop->type == PROPELLER_TYPE_CW ? -1.0f : 1.0f) * prop->torque * spinTorqueScale;
         }
         
         netForce += glm::vec3(0.0f, -mass * gravity, 0.0f) * 40.0f;
         
         glm::vec3 acceleration = netForce / mass;
         velocity += acceleration * deltaTime;
-        velocity *= 0.98f;
+        velocity = wind + (velocity - wind) * linearDamping;
         position += velocity * deltaTime;
         
         glm::quat angularAccel = glm::quat(0.0f, netTorque / inertia);
@@ -77,9 +111,9 @@ public:
             prop->update(deltaTime);
     }
 
-    void reset() {
-        position = glm::vec3(0.0f);
-        rotation = glm::quat(glm::vec3(0.0f));
+    void reset(const glm::vec3& _position = glm::vec3(0.0f), const glm::quat& _rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f)) {
+        position = _position;
+        rotation = _rotation;
         velocity = glm::vec3(0.0f);
         angularVelocity = glm::quat(glm::vec4(0.0f));
 
@@ -96,7 +130,7 @@ public:
     }
 
 
-    void render(Shader shader) {
+    void render(Shader& shader) {
         mesh->render(shader);
         for (int i = 0; i < propellers.size(); ++i)
             propellers[i]->render(shader);
@@ -106,18 +140,87 @@ public:
         #endif
     }
 
+    // Skips the draw calls when the collider bounds, widened by the blades,
+    // are off screen; returns whether the drone was drawn.
+    bool render(Shader& shader, const Frustum& frustum) {
+        glm::vec3 margin(DRONE_CULL_MARGIN);
+        if (!frustum.isBoxVisible(collider->min - margin, collider->max + margin)) return false;
+        render(shader);
+        return true;
+    }
+
+    int lodLevel(const glm::vec3& viewPos) const {
+        float distance = glm::length(position - viewPos);
+        if (distance > DRONE_LOD_DISTANCE_2) return 2;
+        if (distance > DRONE_LOD_DISTANCE_1) return 1;
+        return 0;
+    }
+
+    // Culled and drawn at the level of detail for its distance from
+    // `viewPos`; returns the number of triangles submitted (0 if culled).
+    size_t render(Shader& shader, const Frustum& frustum, const glm::vec3& viewPos) {
+        glm::vec3 margin(DRONE_CULL_MARGIN);
+        if (!frustum.isBoxVisible(collider->min - margin, collider->max + margin)) return 0;
+
+        int level = lodLevel(viewPos);
+        Mesh* body = mesh.get();
+        if (level > 0) {
+            body = lods[level - 1].get();
+            body->model = mesh->model;
+            body->normalMatrix = mesh->normalMatrix;
+        }
+        body->render(shader);
+        size_t triangles = body->indices.size() / 3;
+
+        if (level < DRONE_LOD_COUNT - 1) {
+            for (auto& prop : propellers) {
+                prop->render(shader);
+                triangles += prop->mesh->indices.size() / 3;
+            }
+        }
+        return triangles;
+    }
+
     void setPropellerThrusts(const std::vector<float>& thrusts) {
         for (int i = 0; i < 4 && i < propellers.size(); ++i) {
             propellers[i]->setTargetThrust(thrusts[i]);
         }
     }
 
+    // Reads one thrust per propeller, up to four.
+    void setPropellerThrusts(const float* thrusts) {
+        for (int i = 0; i < 4 && i < propellers.size(); ++i) {
+            propellers[i]->setTargetThrust(thrusts[i]);
+        }
+    }
+
 private:
     std::vector<std::unique_ptr<Propeller>> propellers;
+    std::unique_ptr<Mesh> lods[DRONE_LOD_COUNT - 1];
 
     float mass;
     float gravity;
 
+    // Simplified bodies share the full mesh's origin, so its model and
+    // normal matrices place them. The geometry is built (or read from the
+    // cache next to the OBJ) once and shared by every drone.
+    void initLods(const glm::vec3& color) {
+        static const float ratios[DRONE_LOD_COUNT - 1] = {0.25f, 0.08f};
+        static std::vector<float> lodVertices[DRONE_LOD_COUNT - 1];
+        static std::vector<unsigned int> lodIndices[DRONE_LOD_COUNT - 1];
+
+        for (int l = 0; l < DRONE_LOD_COUNT - 1; ++l) {
+            if (lodIndices[l].empty()) {
+                std::string cachePath = std::string(DRONE_MODEL_PATH) + ".lod" + std::to_string(l + 1) + ".bin";
+                loadOrSimplifyMesh(cachePath, mesh->vertices, mesh->indices, ratios[l], lodVertices[l], lodIndices[l]);
+            }
+            lods[l] = std::make_unique<Mesh>(lodVertices[l].data(), lodVertices[l].size(),
+                                             lodIndices[l].data(), lodIndices[l].size());
+            lods[l]->setOrigin(mesh->origin);
+            lods[l]->setColor(color);
+        }
+    }
+
     void initPropellers() {
         const float scale = 0.75f;
         const glm::vec3 color(0.2f, 0.2f, 0.25f);
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+#include "fixed_matrix.hpp"
+#include "thread_pool.hpp"
+#include "sensors.hpp"
+#include "swarm.hpp"
+
+// Extended Kalman filter over an N-dimensional state. All matrices are
+// fixed-size, so predict and update never touch the heap. The process model
+// is passed either as the propagated state plus its Jacobian, or as any
+// callable x' = f(x) whose Jacobian is then taken by forward differences.
+template <size_t N>
+class ExtendedKalmanFilter {
+public:
+    Matrix<N, 1> x;
+    Matrix<N, N> P;
+
+    ExtendedKalmanFilter()
+        : x(Matrix<N, 1>::zero()), P(Matrix<N, N>::identity()) {}
+
+    void predict(const Matrix<N, 1>& next, const Matrix<N, N>& F, const Matrix<N, N>& Q) {
+        x = next;
+        P = F * P * F.transpose() + Q;
+    }
+
+    template <typename F>
+    void predict(F&& f, const Matrix<N, N>& Q, float epsilon = 1e-4f) {
+        Matrix<N, 1> fx = f(x);
+        Matrix<N, N> J;
+
+        for (size_t j = 0; j < N; ++j) {
+            Matrix<N, 1> xp = x;
+            xp.m[j][0] += epsilon;
+            Matrix<N, 1> fp = f(xp);
+            for (size_t i = 0; i < N; ++i)
+                J.m[i][j] = (fp.m[i][0] - fx.m[i][0]) / epsilon;
+        }
+
+        x = fx;
+        P = J * P * J.transpose() + Q;
+    }
+
+    // Fuses a measurement with residual y = z - h(x) and Jacobian H, using the
+    // Joseph form so P stays symmetric positive definite in single precision.
+    template <size_t M>
+    bool update(const Matrix<M, 1>& residual, const Matrix<M, N>& H, const Matrix<M, M>& R) {
+        Matrix<N, M> PHt = P * H.transpose();
+        Matrix<M, M> S = H * PHt + R;
+        Matrix<M, M> Sinv;
+        if (!invert(S, Sinv)) return false;
+
+        Matrix<N, M> K = PHt * Sinv;
+        x += K * residual;
+
+        Matrix<N, N> IKH = Matrix<N, N>::identity() - K * H;
+        P = IKH * P * IKH.transpose() + K * R * K.transpose();
+        return true;
+    }
+};
+
+#define ESTIMATOR_STATE_SIZE 10
+
+struct EstimatorConfig {
+    float accelNoise = 0.5f;
+    float gyroNoise = 0.01f;
+    float gpsPositionNoise = 1.5f;
+    float gpsVelocityNoise = 0.2f;
+    float baroNoise = 0.5f;
+
+    // Swarm damps velocity by 0.98 per 60 Hz step without it appearing in
+    // the measured acceleration; modelled here as linear drag, -ln(0.98) * 60.
+    float velocityDrag = 1.2122f;
+
+    float initialPositionVariance = 1.0f;
+    float initialVelocityVariance = 1.0f;
+    float initialRotationVariance = 1e-4f;
+};
+
+// Position / velocity / attitude filter for one drone, driven by IMU samples
+// and corrected by GPS and barometer readings. State layout:
+// [ position(3) | velocity(3) | rotation quaternion w, x, y, z (4) ].
+class DroneEstimator {
+public:
+    ExtendedKalmanFilter<ESTIMATOR_STATE_SIZE> filter;
+
+    DroneEstimator() { reset(glm::vec3(0.0f)); }
+
+    void reset(const glm::vec3& position, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+               const EstimatorConfig& config = EstimatorConfig()) {
+        auto& x = filter.x;
+        x = Matrix<ESTIMATOR_STATE_SIZE, 1>::zero();
+        x[0] = position.x; x[1] = position.y; x[2] = position.z;
+        x[6] = rotation.w; x[7] = rotation.x; x[8] = rotation.y; x[9] = rotation.z;
+
+        auto& P = filter.P;
+        P = Matrix<ESTIMATOR_STATE_SIZE, ESTIMATOR_STATE_SIZE>::zero();
+        for (int k = 0; k < 3; ++k) {
+            P(k, k) = config.initialPositionVariance;
+            P(3 + k, 3 + k) = config.initialVelocityVariance;
+        }
+        for (int k = 6; k < 10; ++k)
+            P(k, k) = config.initialRotationVariance;
+    }
+
+    glm::vec3 position() const { return {filter.x[0], filter.x[1], filter.x[2]}; }
+    glm::vec3 velocity() const { return {filter.x[3], filter.x[4], filter.x[5]}; }
+    glm::quat rotation() const { return glm::quat(filter.x[6], filter.x[7], filter.x[8], filter.x[9]); }
+
+    void predict(const ImuSample& imu, float deltaTime, const glm::vec3& gravity, const EstimatorConfig& config) {
+        auto& x = filter.x;
+        glm::quat q(x[6], x[7], x[8], x[9]);
+        glm::vec3 u(q.x, q.y, q.z);
+        glm::vec3 v(x[3], x[4], x[5]);
+        const glm::vec3& a = imu.accel;
+        const glm::vec3& w = imu.gyro;
+
+        glm::vec3 accel = q * a + gravity - config.velocityDrag * v;
+        glm::quat dq = q * glm::quat(0.0f, w) * (0.5f * deltaTime);
+
+        Matrix<ESTIMATOR_STATE_SIZE, 1> next;
+        for (int k = 0; k < 3; ++k) {
+            next[k] = x[k] + v[k] * deltaTime;
+            next[3 + k] = v[k] + accel[k] * deltaTime;
+        }
+        next[6] = q.w + dq.w; next[7] = q.x + dq.x; next[8] = q.y + dq.y; next[9] = q.z + dq.z;
+
+        // Analytic Jacobian. Finite differences lose the position columns to
+        // float rounding once drones are a few hundred units from the origin.
+        auto F = Matrix<ESTIMATOR_STATE_SIZE, ESTIMATOR_STATE_SIZE>::identity();
+        float damp = 1.0f - config.velocityDrag * deltaTime;
+        for (int k = 0; k < 3; ++k) {
+            F(k, 3 + k) = deltaTime;
+            F(3 + k, 3 + k) = damp;
+        }
+
+        // d(q * a)/dq with q * a = a + 2w(u x a) + 2u x (u x a).
+        glm::vec3 ua = glm::cross(u, a);
+        float udota = glm::dot(u, a);
+        for (int r = 0; r < 3; ++r) {
+            F(3 + r, 6) = 2.0f * ua[r] * deltaTime;
+            for (int c = 0; c < 3; ++c) {
+                float d = 2.0f * ((r == c ? udota : 0.0f) + u[r] * a[c] - 2.0f * a[r] * u[c]);
+                F(3 + r, 7 + c) = d * deltaTime;
+            }
+        }
+        float hw = 2.0f * q.w * deltaTime;
+        F(3, 8) += hw * a.z; F(3, 9) -= hw * a.y;
+        F(4, 7) -= hw * a.z; F(4, 9) += hw * a.x;
+        F(5, 7) += hw * a.y; F(5, 8) -= hw * a.x;
+
+        // d(q + 0.5 dt q (0, w))/dq.
+        float h = 0.5f * deltaTime;
+        F(6, 7) = -h * w.x; F(6, 8) = -h * w.y; F(6, 9) = -h * w.z;
+        F(7, 6) =  h * w.x; F(7, 8) =  h * w.z; F(7, 9) = -h * w.y;
+        F(8, 6) =  h * w.y; F(8, 7) = -h * w.z; F(8, 9) =  h * w.x;
+        F(9, 6) =  h * w.z; F(9, 7) =  h * w.y; F(9, 8) = -h * w.x;
+
+        auto Q = Matrix<ESTIMATOR_STATE_SIZE, ESTIMATOR_STATE_SIZE>::zero();
+        float va = config.accelNoise * config.accelNoise * deltaTime * deltaTime;
+        float vg = config.gyroNoise * config.gyroNoise * deltaTime * deltaTime * 0.25f;
+        for (int k = 0; k < 3; ++k) {
+            Q(k, k) = 0.25f * va * deltaTime * deltaTime;
+            Q(3 + k, 3 + k) = va;
+        }
+        for (int k = 6; k < 10; ++k)
+            Q(k, k) = vg;
+
+        filter.predict(next, F, Q);
+        normalizeRotation();
+    }
+
+    void fuseGps(const GpsSample& gps, const EstimatorConfig& config) {
+        Matrix<6, 1> y;
+        auto H = Matrix<6, ESTIMATOR_STATE_SIZE>::zero();
+        auto R = Matrix<6, 6>::zero();
+        float rp = config.gpsPositionNoise * config.gpsPositionNoise;
+        float rv = config.gpsVelocityNoise * config.gpsVelocityNoise;
+
+        for (int k = 0; k < 3; ++k) {
+            y[k] = gps.position[k] - filter.x[k];
+            y[3 + k] = gps.velocity[k] - filter.x[3 + k];
+            H(k, k) = 1.0f;
+            H(3 + k, 3 + k) = 1.0f;
+            R(k, k) = rp;
+            R(3 + k, 3 + k) = rv;
+        }
+
+        filter.update(y, H, R);
+        normalizeRotation();
+    }
+
+    void fuseBaro(const BaroSample& baro, const EstimatorConfig& config) {
+        Matrix<1, 1> y;
+        y[0] = baro.altitude - filter.x[1];
+        auto H = Matrix<1, ESTIMATOR_STATE_SIZE>::zero();
+        H(0, 1) = 1.0f;
+        Matrix<1, 1> R;
+        R[0] = config.baroNoise * config.baroNoise;
+
+        filter.update(y, H, R);
+    }
+
+private:
+    void normalizeRotation() {
+        auto& x = filter.x;
+        float len = std::sqrt(x[6] * x[6] + x[7] * x[7] + x[8] * x[8] + x[9] * x[9]);
+        if (len <= 0.0f) {
+            x[6] = 1.0f; x[7] = x[8] = x[9] = 0.0f;
+            return;
+        }
+        for (int k = 6; k < 10; ++k)
+            x[k] /= len;
+    }
+};
+
+// One DroneEstimator per drone. update() consumes every IMU, barometer and
+// GPS sample that became available since the previous call, in order, and
+// can spread the swarm over a thread pool.
+class EstimatorBank {
+public:
+    EstimatorConfig config;
+
+    explicit EstimatorBank(size_t count, const EstimatorConfig& _config = EstimatorConfig())
+        : config(_config), filters(count), imuRead(count, 0), baroRead(count, 0), gpsRead(count, 0),
+          totalUpdates(0), totalSeconds(0.0) {}
+
+    size_t size() const { return filters.size(); }
+    DroneEstimator& operator[](size_t i) { return filters[i]; }
+    const DroneEstimator& operator[](size_t i) const { return filters[i]; }
+
+    void reset(size_t i, const glm::vec3& position, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f)) {
+        filters[i].reset(position, rotation, config);
+        imuRead[i] = baroRead[i] = gpsRead[i] = 0;
+    }
+
+    void update(const SensorSuite& sensors, const glm::vec3& gravity, ThreadPool* pool = nullptr) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        size_t count = std::min(size(), sensors.size());
+
+        auto range = [&](size_t begin, size_t end, unsigned int) {
+            for (size_t i = begin; i < end; ++i)
+                updateDrone(sensors, gravity, i);
+        };
+        if (pool) pool->parallelFor(count, range, 64);
+        else range(0, count, 0);
+
+        auto T1 = std::chrono::high_resolution_clock::now();
+        totalSeconds += std::chrono::duration<double>(T1 - T0).count();
+        totalUpdates += count;
+    }
+
+    // Drone-estimator updates (one per drone per update() call) per second.
+    double updatesPerSecond() const {
+        return totalSeconds > 0.0 ? double(totalUpdates) / totalSeconds : 0.0;
+    }
+
+private:
+    std::vector<DroneEstimator> filters;
+    std::vector<uint64_t> imuRead;
+    std::vector<uint64_t> baroRead;
+    std::vector<uint64_t> gpsRead;
+
+    size_t totalUpdates;
+    double totalSeconds;
+
+    void updateDrone(const SensorSuite& sensors, const glm::vec3& gravity, size_t i) {
+        const float imuDt = 1.0f / sensors.config.imuRate;
+
+        uint64_t imuEnd = sensors.imuAvailable(i);
+        imuRead[i] = std::max(imuRead[i], imuEnd > SENSOR_HISTORY ? imuEnd - SENSOR_HISTORY : 0);
+        for (; imuRead[i] < imuEnd; ++imuRead[i])
+            filters[i].predict(sensors.imuSample(i, imuRead[i]), imuDt, gravity, config);
+
+        uint64_t baroEnd = sensors.baroAvailable(i);
+        baroRead[i] = std::max(baroRead[i], baroEnd > SENSOR_HISTORY ? baroEnd - SENSOR_HISTORY : 0);
+        for (; baroRead[i] < baroEnd; ++baroRead[i])
+            filters[i].fuseBaro(sensors.baroSample(i, baroRead[i]), config);
+
+        uint64_t gpsEnd = sensors.gpsAvailable(i);
+        gpsRead[i] = std::max(gpsRead[i], gpsEnd > SENSOR_HISTORY ? gpsEnd - SENSOR_HISTORY : 0);
+        for (; gpsRead[i] < gpsEnd; ++gpsRead[i])
+            filters[i].fuseGps(sensors.gpsSample(i, gpsRead[i]), config);
+    }
+};
+
+// Runs `steps` physics steps of a hovering swarm of `count` drones with
+// sensors and estimators attached, and returns IMU-driven filter
+// predictions per second (the dominant estimator cost).
+inline double benchmarkEstimators(size_t count, size_t steps = 60, ThreadPool* pool = nullptr) {
+    Swarm swarm(count);
+    SensorSuite sensors(count);
+    EstimatorBank bank(count);
+    for (size_t i = 0; i < count; ++i) {
+        swarm.reset(i, glm::vec3(float(i % 64), 10.0f, float(i / 64)));
+        swarm.setPropellerThrusts(i, glm::vec4(0.51f));
+        bank.reset(i, swarm.position[i]);
+    }
+
+    const float dt = 1.0f / 60.0f;
+    double seconds = 0.0;
+    for (size_t s = 0; s < steps; ++s) {
+        swarm.update(dt);
+        sensors.update(swarm, dt);
+        auto T0 = std::chrono::high_resolution_clock::now();
+        bank.update(sensors, swarm.gravityAcceleration(), pool);
+        seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - T0).count();
+    }
+
+    double predictions = double(count) * double(steps) * dt * sensors.config.imuRate;
+    return seconds > 0.0 ? predictions / seconds : 0.0;
+}
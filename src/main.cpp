@@ -1,6 +1,10 @@
 #include "app.hpp"
 #include "shader.hpp"
 #include "camera.hpp"
+#include "frustum.hpp"
+#include "gpu_timer.hpp"
+#include "frame_uniforms.hpp"
+#include "gl_state.hpp"
 
 #include "simulation.hpp"
 
@@ -11,7 +15,7 @@ int main() {
     Shader shader("../res/shaders/light_vert.glsl", "../res/shaders/light_frag.glsl");
 
     Camera camera(glm::vec3(0.0f, 0.0f, -6.0f));
-    glm::mat4 proj = glm::perspective(70.0f, app.getAspectRatio(), 1.0f, 3.0f);
+    glm::mat4 proj = glm::perspective(glm::radians(70.0f), app.getAspectRatio(), 0.1f, 1000.0f);
     camera.setInputMode(window);
 
     Simulation sim(glm::vec3(-250.0f), glm::vec3(250.0f), 25.0f, 50.0f, 512, 100);
@@ -20,20 +24,46 @@ int main() {
     box.translate({0.0f, 50.0f, 0.0f});
     box.setColor({1.0f, 0.0f, 0.0f, 0.2f});
 
+    Frustum frustum;
+    // Build with -DFRAME_STATS to print GPU time and GL call counts.
+    #ifdef FRAME_STATS
+    GpuTimer sceneTimer;
+    size_t frame = 0;
+    #endif
+
+    FrameUniforms frameUniforms;
+    frameUniforms.attach(shader);
+    frameUniforms.setLight({0.0f, 80.0f, 0.0f}, {0.96f, 0.98f, 1.0f});
+
     shader.bind();
     app.run([&](float deltaTime) {
+        GlState::get().beginFrame();
+
         camera.processKeyboard(window, deltaTime);
         camera.processMouse(window, deltaTime);
-        camera.setUniforms(shader, proj);
-
-        shader.setUniform3f("lightColor", {0.96f, 0.98f, 1.0f});
-        shader.setUniform3f("lightPos", {0.0f, 80.0f, 0.0f});
-        shader.setUniform3f("viewPos", camera.position);
+        camera.setUniforms(frameUniforms, proj);
+        frameUniforms.upload();
+        frustum.update(frameUniforms.data.viewProj);
 
         sim.update(deltaTime, {0.0f, 50.0f, 0.0f});
+
+        #ifdef FRAME_STATS
+        sceneTimer.begin();
+        #endif
         sim.render(shader);
 
-        box.render(shader);
+        if (frustum.isBoxVisible(box.min, box.max, box.model))
+            box.render(shader);
+
+        #ifdef FRAME_STATS
+        sceneTimer.end();
+        if (++frame % 300 == 0) {
+            const GlCallStats& calls = GlState::get().getStats();
+            std::cout << "GPU scene: " << sceneTimer.getAverageMillis() << " ms, GL state calls: "
+                      << calls.issued << " issued, " << calls.skipped << " skipped, draws: " << calls.draws << '\n';
+            sceneTimer.resetAverage();
+        }
+        #endif
     });
 
     return 0;
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "fixed_matrix.hpp"
+#include "thread_pool.hpp"
+
+#define MIN_SNAP_COEFFS 8
+
+// Segment lookup buckets per segment; evaluation starts from the bucket's
+// segment and steps forward, so lookups stay O(1) unless durations differ
+// by more than this factor.
+#ifndef MIN_SNAP_BUCKETS_PER_SEGMENT
+    #define MIN_SNAP_BUCKETS_PER_SEGMENT 4
+#endif
+
+// N segments through N + 1 waypoints. Durations are per segment; velocity
+// at the ends is given, acceleration and jerk there are zero.
+template <size_t N>
+struct MinSnapProblem {
+    glm::vec3 waypoints[N + 1];
+    float durations[N];
+    glm::vec3 startVelocity = glm::vec3(0.0f);
+    glm::vec3 endVelocity = glm::vec3(0.0f);
+
+    // Durations proportional to segment length at the given mean speed.
+    void allocateTimes(float speed, float minimum = 0.1f) {
+        for (size_t i = 0; i < N; ++i)
+            durations[i] = std::max(glm::length(waypoints[i + 1] - waypoints[i]) / speed, minimum);
+    }
+};
+
+struct MinSnapStats {
+    size_t trajectories;
+    size_t factorizations;
+    size_t failures;
+    double wallMicros;
+    double meanSolveMicros;
+};
+
+// Piecewise degree-7 polynomial. Segment i is stored in normalised time
+// s = (t - startTime[i]) / duration_i in [0, 1], which keeps the
+// coefficients of long and short segments on the same scale.
+template <size_t N>
+struct MinSnapTrajectory {
+    glm::vec3 coeffs[N][MIN_SNAP_COEFFS];
+    float startTime[N + 1];
+    float invDuration[N];
+    uint16_t buckets[N * MIN_SNAP_BUCKETS_PER_SEGMENT];
+    float bucketScale;
+
+    float duration() const { return startTime[N]; }
+
+    size_t segmentAt(float t) const {
+        int b = std::min(std::max(int(t * bucketScale), 0), int(N * MIN_SNAP_BUCKETS_PER_SEGMENT) - 1);
+        size_t i = buckets[b];
+        while (i + 1 < N && t >= startTime[i + 1]) ++i;
+        return i;
+    }
+
+    glm::vec3 position(float t) const {
+        t = std::min(std::max(t, 0.0f), startTime[N]);
+        size_t i = segmentAt(t);
+        float s = (t - startTime[i]) * invDuration[i];
+        const glm::vec3* c = coeffs[i];
+        glm::vec3 p = c[7];
+        for (int k = 6; k >= 0; --k) p = p * s + c[k];
+        return p;
+    }
+
+    // Position, velocity and acceleration at time t (clamped to the
+    // trajectory), by Horner's rule on the segment polynomial and its
+    // first two derivatives.
+    void evaluate(float t, glm::vec3& position, glm::vec3& velocity, glm::vec3& acceleration) const {
+        t = std::min(std::max(t, 0.0f), startTime[N]);
+        size_t i = segmentAt(t);
+        float s = (t - startTime[i]) * invDuration[i], inv = invDuration[i];
+        const glm::vec3* c = coeffs[i];
+
+        glm::vec3 p = c[7], v = 7.0f * c[7], a = 42.0f * c[7];
+        for (int k = 6; k >= 0; --k) {
+            p = p * s + c[k];
+            if (k >= 1) v = v * s + float(k) * c[k];
+            if (k >= 2) a = a * s + float(k * (k - 1)) * c[k];
+        }
+        position = p;
+        velocity = v * inv;
+        acceleration = a * (inv * inv);
+    }
+
+    void setTimes(const float (&durations)[N]) {
+        startTime[0] = 0.0f;
+        for (size_t i = 0; i < N; ++i) {
+            startTime[i + 1] = startTime[i] + durations[i];
+            invDuration[i] = 1.0f / durations[i];
+        }
+        bucketScale = float(N * MIN_SNAP_BUCKETS_PER_SEGMENT) / startTime[N];
+        size_t i = 0;
+        for (size_t b = 0; b < N * MIN_SNAP_BUCKETS_PER_SEGMENT; ++b) {
+            float t = float(b) / bucketScale;
+            while (i + 1 < N && t >= startTime[i + 1]) ++i;
+            buckets[b] = uint16_t(i);
+        }
+    }
+};
+
+// Minimum-snap solver for N segments. Minimising the integral of squared
+// snap through fixed waypoints gives degree-7 segments that are C6 at the
+// interior waypoints, so instead of a QP the coefficients solve one 8N x 8N
+// linear system: positions at both ends of every segment, continuity of
+// derivatives 1-6 at interior waypoints, and velocity, acceleration and
+// jerk at the two ends. The matrix depends only on the durations, so its LU
+// factorisation is kept and reused while they do not change; x, y and z are
+// solved together as three right-hand sides.
+template <size_t N>
+class MinSnapSolver {
+public:
+    static constexpr size_t SIZE = MIN_SNAP_COEFFS * N;
+
+    MinSnapSolver() : factored(false) {}
+
+    bool solve(const MinSnapProblem<N>& problem, MinSnapTrajectory<N>& out) {
+        for (float d : problem.durations)
+            if (!(d > 0.0f) || !std::isfinite(d)) return false;
+
+        if (!factored || !std::equal(problem.durations, problem.durations + N, durations)) {
+            if (!factor(problem.durations)) return false;
+        }
+
+        Matrix<SIZE, 3>& b = rhs;
+        b = Matrix<SIZE, 3>::zero();
+        size_t row = 0;
+        for (size_t i = 0; i < N; ++i) {
+            setRow(b, row++, problem.waypoints[i]);
+            setRow(b, row++, problem.waypoints[i + 1]);
+        }
+        // Velocity in normalised time is duration * velocity.
+        setRow(b, row, problem.startVelocity * durations[0]);
+        setRow(b, row + 3, problem.endVelocity * durations[N - 1]);
+
+        luSolve(lu, pivots, b, solution);
+        out.setTimes(problem.durations);
+        for (size_t i = 0; i < N; ++i)
+            for (size_t k = 0; k < MIN_SNAP_COEFFS; ++k) {
+                size_t r = i * MIN_SNAP_COEFFS + k;
+                out.coeffs[i][k] = glm::vec3(solution.m[r][0], solution.m[r][1], solution.m[r][2]);
+            }
+        return true;
+    }
+
+    size_t factorizations = 0;
+
+private:
+    Matrix<SIZE, SIZE> lu;
+    Matrix<SIZE, 3> rhs;
+    Matrix<SIZE, 3> solution;
+    size_t pivots[SIZE];
+    float durations[N];
+    bool factored;
+
+    static void setRow(Matrix<SIZE, 3>& b, size_t row, const glm::vec3& v) {
+        b.m[row][0] = v.x;
+        b.m[row][1] = v.y;
+        b.m[row][2] = v.z;
+    }
+
+    // d^j/ds^j of s^k, divided by j! so rows stay O(1) for high derivatives.
+    static float derivative(size_t k, size_t j, float s) {
+        if (k < j) return 0.0f;
+        float f = 1.0f;
+        for (size_t m = 0; m < j; ++m) f *= float(k - m) / float(m + 1);
+        return f * std::pow(s, float(k - j));
+    }
+
+    bool factor(const float (&_durations)[N]) {
+        std::copy(_durations, _durations + N, durations);
+        lu = Matrix<SIZE, SIZE>::zero();
+        size_t row = 0;
+
+        for (size_t i = 0; i < N; ++i) {
+            lu.m[row++][i * MIN_SNAP_COEFFS] = 1.0f;
+            for (size_t k = 0; k < MIN_SNAP_COEFFS; ++k) lu.m[row][i * MIN_SNAP_COEFFS + k] = 1.0f;
+            ++row;
+        }
+
+        // Velocity (scaled by 1!), acceleration and jerk at both ends.
+        for (size_t j = 1; j <= 3; ++j) {
+            for (size_t k = 0; k < MIN_SNAP_COEFFS; ++k) {
+                lu.m[row + j - 1][k] = derivative(k, j, 0.0f);
+                lu.m[row + j + 2][(N - 1) * MIN_SNAP_COEFFS + k] = derivative(k, j, 1.0f);
+            }
+        }
+        row += 6;
+
+        // Time-derivative j of segment i at s = 1 equals that of segment
+        // i + 1 at s = 0; both sides are multiplied by duration_i^j.
+        for (size_t i = 0; i + 1 < N; ++i) {
+            float ratio = durations[i] / durations[i + 1];
+            for (size_t j = 1; j <= 6; ++j, ++row) {
+                float scale = std::pow(ratio, float(j));
+                for (size_t k = 0; k < MIN_SNAP_COEFFS; ++k) {
+                    lu.m[row][i * MIN_SNAP_COEFFS + k] = derivative(k, j, 1.0f);
+                    lu.m[row][(i + 1) * MIN_SNAP_COEFFS + k] = -scale * derivative(k, j, 0.0f);
+                }
+            }
+        }
+
+        ++factorizations;
+        factored = luDecompose(lu, pivots);
+        return factored;
+    }
+};
+
+// Solves many MinSnapProblems over the pool. Each worker owns a solver,
+// and consecutive problems with identical durations (e.g. a formation
+// flying the same timed route) reuse its factorisation, so only the
+// triangular solves are paid per drone.
+template <size_t N>
+class MinSnapBatch {
+public:
+    explicit MinSnapBatch(ThreadPool* _pool = nullptr)
+        : pool(_pool), stats{0, 0, 0, 0.0, 0.0}
+    {
+        unsigned int workers = pool ? pool->size() : 1;
+        for (unsigned int w = 0; w < workers; ++w)
+            solvers.push_back(std::make_unique<MinSnapSolver<N>>());
+    }
+
+    const MinSnapStats& getStats() const { return stats; }
+
+    // ok[i] is 0 where a duration is not positive and finite, or the system
+    // was singular.
+    void solve(const std::vector<MinSnapProblem<N>>& problems, std::vector<MinSnapTrajectory<N>>& out,
+               std::vector<uint8_t>& ok) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        out.resize(problems.size());
+        ok.resize(problems.size());
+        solveMicros.resize(problems.size());
+        size_t before = 0;
+        for (auto& s : solvers) before += s->factorizations;
+
+        auto range = [&](size_t begin, size_t end, unsigned int worker) {
+            for (size_t i = begin; i < end; ++i) {
+                auto S0 = std::chrono::high_resolution_clock::now();
+                ok[i] = solvers[worker]->solve(problems[i], out[i]);
+                auto S1 = std::chrono::high_resolution_clock::now();
+                solveMicros[i] = std::chrono::duration<double, std::micro>(S1 - S0).count();
+            }
+        };
+        if (pool) pool->parallelFor(problems.size(), range);
+        else range(0, problems.size(), 0);
+
+        auto T1 = std::chrono::high_resolution_clock::now();
+        stats.trajectories = problems.size();
+        stats.factorizations = 0;
+        for (auto& s : solvers) stats.factorizations += s->factorizations;
+        stats.factorizations -= before;
+        stats.failures = size_t(std::count(ok.begin(), ok.end(), uint8_t(0)));
+        stats.wallMicros = std::chrono::duration<double, std::micro>(T1 - T0).count();
+        stats.meanSolveMicros = 0.0;
+        for (double us : solveMicros) stats.meanSolveMicros += us;
+        if (!problems.empty()) stats.meanSolveMicros /= double(problems.size());
+    }
+
+private:
+    ThreadPool* pool;
+    std::vector<std::unique_ptr<MinSnapSolver<N>>> solvers;
+    std::vector<double> solveMicros;
+    MinSnapStats stats;
+};
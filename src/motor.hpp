@@ -0,0 +1,95 @@
+#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#ifndef MOTOR_CURVE_SIZE
+    #define MOTOR_CURVE_SIZE 33
+#endif
+
+// Thrust and reaction torque of one rotor as a function of normalised rotor
+// speed (0 = stopped, 1 = max RPM), tabulated at MOTOR_CURVE_SIZE evenly
+// spaced speeds and read back by linear interpolation. Outputs are
+// normalised as well: 1 means maxThrust / spinTorqueScale of the airframe.
+// The default table is the ideal propeller law, both curves proportional to
+// speed squared; measured curves can be loaded with loadMotorCurve.
+struct MotorCurve {
+    float thrust[MOTOR_CURVE_SIZE];
+    float torque[MOTOR_CURVE_SIZE];
+
+    constexpr MotorCurve() : thrust(), torque() {
+        for (size_t i = 0; i < MOTOR_CURVE_SIZE; ++i) {
+            float s = float(i) / float(MOTOR_CURVE_SIZE - 1);
+            thrust[i] = s * s;
+            torque[i] = s * s;
+        }
+    }
+
+    // Branch-free so loops over many rotors stay vectorisable.
+    static float lookup(const float* table, float speed) {
+        float x = speed * float(MOTOR_CURVE_SIZE - 1);
+        x = x < 0.0f ? 0.0f : (x > float(MOTOR_CURVE_SIZE - 1) ? float(MOTOR_CURVE_SIZE - 1) : x);
+        int i = int(x);
+        i = i < MOTOR_CURVE_SIZE - 2 ? i : MOTOR_CURVE_SIZE - 2;
+        float f = x - float(i);
+        return table[i] + (table[i + 1] - table[i]) * f;
+    }
+
+    float thrustAt(float speed) const { return lookup(thrust, speed); }
+    float torqueAt(float speed) const { return lookup(torque, speed); }
+};
+
+inline constexpr MotorCurve DEFAULT_MOTOR_CURVE = MotorCurve();
+
+// First-order rotor speed response followed by the curve lookup, over a flat
+// run of rotors. `response` is per drone (1 / motor time constant), so rotor
+// r uses response[r / rotorsPerDrone].
+inline void updateMotors(const MotorCurve& curve, const float* command, const float* response, size_t rotorsPerDrone,
+                         float* speed, float* thrust, float* torque, size_t count, float deltaTime) {
+    for (size_t r = 0; r < count; ++r) {
+        float s = speed[r] + (command[r] - speed[r]) * response[r / rotorsPerDrone] * deltaTime;
+        speed[r] = s;
+        thrust[r] = MotorCurve::lookup(curve.thrust, s);
+        torque[r] = MotorCurve::lookup(curve.torque, s);
+    }
+}
+
+// Loads a curve from a text file of "speed thrust torque" rows with speed
+// ascending over [0, 1], resampling it onto the table.
+inline bool loadMotorCurve(const std::string& path, MotorCurve& curve) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open motor curve file: " << path << "\n";
+        return false;
+    }
+
+    std::vector<float> speeds, thrusts, torques;
+    float s, t, q;
+    while (file >> s >> t >> q) {
+        if (!speeds.empty() && s <= speeds.back()) {
+            std::cerr << "Error: Motor curve speeds must be ascending: " << path << "\n";
+            return false;
+        }
+        speeds.push_back(s);
+        thrusts.push_back(t);
+        torques.push_back(q);
+    }
+    if (speeds.size() < 2) {
+        std::cerr << "Error: Motor curve needs at least two rows: " << path << "\n";
+        return false;
+    }
+
+    size_t k = 0;
+    for (size_t i = 0; i < MOTOR_CURVE_SIZE; ++i) {
+        float x = float(i) / float(MOTOR_CURVE_SIZE - 1);
+        while (k + 2 < speeds.size() && speeds[k + 1] < x) ++k;
+        float f = (x - speeds[k]) / (speeds[k + 1] - speeds[k]);
+        f = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+        curve.thrust[i] = thrusts[k] + (thrusts[k + 1] - thrusts[k]) * f;
+        curve.torque[i] = torques[k] + (torques[k + 1] - torques[k]) * f;
+    }
+    return true;
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "thread_pool.hpp"
+#include "swarm.hpp"
+
+#ifndef MPPI_LANES
+    #define MPPI_LANES 8
+#endif
+
+struct MppiConfig {
+    size_t samples = 256;
+    size_t horizon = 30;
+    float timeStep = 1.0f / 30.0f;
+    float noiseStd = 0.15f;
+    float lambda = 1.0f;
+
+    float positionWeight = 1.0f;
+    float velocityWeight = 0.05f;
+    float uprightWeight = 50.0f;
+    float controlWeight = 0.1f;
+    float hoverThrust = 0.51f;
+};
+
+struct MppiStats {
+    double meanDecisionMicros;
+    double maxDecisionMicros;
+    double wallMicros;
+};
+
+// Model-predictive path integral controller. For every drone it perturbs a
+// nominal thrust sequence with `samples` noise sequences, rolls each one out
+// through a stripped-down copy of the Swarm/Drone dynamics, and re-weights
+// the nominal sequence by exp(-cost / lambda). Rollout state is kept as one
+// float array per component so the per-sample loops vectorize; drones are
+// spread over the thread pool and every worker owns preallocated scratch, so
+// control() performs no allocation.
+class MppiController {
+public:
+    MppiController(size_t droneCount, ThreadPool& _pool, const MppiConfig& _config = MppiConfig())
+        : config(_config), pool(_pool), decision(0)
+    {
+        config.samples = (std::max<size_t>(config.samples, 1) + MPPI_LANES - 1) / MPPI_LANES * MPPI_LANES;
+        nominal.assign(droneCount * config.horizon * SWARM_PROPELLER_COUNT, config.hoverThrust);
+        decisionMicros.assign(droneCount, 0.0);
+        for (unsigned int i = 0; i < pool.size(); ++i)
+            workspaces.push_back(std::make_unique<Workspace>(config));
+    }
+
+    void control(Swarm& swarm, const glm::vec3& target) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        size_t count = std::min(swarm.size(), decisionMicros.size());
+
+        pool.parallelFor(count, [&](size_t begin, size_t end, unsigned int worker) {
+            for (size_t i = begin; i < end; ++i) {
+                auto D0 = std::chrono::high_resolution_clock::now();
+                plan(*workspaces[worker], swarm, i, target);
+                auto D1 = std::chrono::high_resolution_clock::now();
+                decisionMicros[i] = std::chrono::duration<double, std::micro>(D1 - D0).count();
+            }
+        }, 1);
+
+        auto T1 = std::chrono::high_resolution_clock::now();
+        stats.wallMicros = std::chrono::duration<double, std::micro>(T1 - T0).count();
+        stats.meanDecisionMicros = 0.0;
+        stats.maxDecisionMicros = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            stats.meanDecisionMicros += decisionMicros[i];
+            stats.maxDecisionMicros = std::max(stats.maxDecisionMicros, decisionMicros[i]);
+        }
+        stats.meanDecisionMicros /= double(std::max<size_t>(count, 1));
+        ++decision;
+    }
+
+    const MppiStats& getStats() const { return stats; }
+
+private:
+    struct Workspace {
+        std::vector<float> noise;
+        std::vector<float> cost;
+
+        explicit Workspace(const MppiConfig& config)
+            : noise(config.samples * config.horizon * SWARM_PROPELLER_COUNT), cost(config.samples) {}
+    };
+
+    MppiConfig config;
+    ThreadPool& pool;
+    std::vector<std::unique_ptr<Workspace>> workspaces;
+    std::vector<float> nominal;
+    std::vector<double> decisionMicros;
+    uint64_t decision;
+    MppiStats stats = {};
+
+    static uint32_t hash(uint32_t x) {
+        x ^= x >> 16; x *= 0x7feb352du;
+        x ^= x >> 15; x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Bit-trick estimate refined by two Newton steps (relative error ~1e-6).
+    // Unlike std::sqrt it never touches errno, so the rollout loop vectorizes.
+    static float inverseSqrt(float x) {
+        uint32_t i;
+        float y;
+        std::memcpy(&i, &x, sizeof(float));
+        i = 0x5f375a86u - (i >> 1);
+        std::memcpy(&y, &i, sizeof(float));
+        y = y * (1.5f - 0.5f * x * y * y);
+        y = y * (1.5f - 0.5f * x * y * y);
+        return y;
+    }
+
+    void sampleNoise(Workspace& w, size_t drone) {
+        // Irwin-Hall approximation of a normal: four uniforms, no transcendentals.
+        const float scale = config.noiseStd * 1.7320508f / 4294967296.0f;
+        uint32_t seed = hash(uint32_t(drone) * 0x9e3779b9u ^ uint32_t(decision) * 0x85ebca6bu);
+        for (size_t n = 0; n < w.noise.size(); ++n) {
+            uint32_t k = seed + uint32_t(n) * 4u;
+            float sum = float(hash(k)) + float(hash(k + 1)) + float(hash(k + 2)) + float(hash(k + 3));
+            w.noise[n] = (sum - 2.0f * 4294967296.0f) * scale;
+        }
+    }
+
+    void plan(Workspace& w, Swarm& swarm, size_t drone, const glm::vec3& target) {
+        const size_t K = config.samples;
+        const size_t H = config.horizon;
+        const size_t P = SWARM_PROPELLER_COUNT;
+        const float dt = config.timeStep;
+        // Downwash loss, like wind, is held at its current value.
+        const float maxThrust = swarm.maxThrust[drone] * swarm.thrustScale[drone];
+        const float spinTorqueScale = swarm.spinTorqueScale[drone];
+        const float motorResponse = swarm.motorResponse[drone];
+        const float damping = swarm.linearDamping[drone];
+        // Wind is held at its current value over the horizon.
+        const glm::vec3 windDrag = swarm.wind[drone] * (1.0f - damping);
+        const float invMass = 1.0f / swarm.mass[drone];
+        const glm::vec3 invInertia = 1.0f / swarm.inertia[drone];
+        const float gravityAccel = -swarm.gravity * 40.0f;
+
+        float* u = nominal.data() + drone * H * P;
+        sampleNoise(w, drone);
+
+        // Body-frame torque arm per unit thrust: offset x up = (-o.z, 0, o.x).
+        float armX[SWARM_PROPELLER_COUNT], armZ[SWARM_PROPELLER_COUNT], spin[SWARM_PROPELLER_COUNT];
+        for (size_t p = 0; p < P; ++p) {
+            armX[p] = -SWARM_PROPELLER_OFFSETS[p].z;
+            armZ[p] =  SWARM_PROPELLER_OFFSETS[p].x;
+            spin[p] = (SWARM_PROPELLER_TYPES[p] == PROPELLER_TYPE_CW ? -1.0f : 1.0f) * spinTorqueScale;
+        }
+
+        const glm::vec3 p0 = swarm.position[drone], v0 = swarm.velocity[drone];
+        const glm::quat q0 = swarm.rotation[drone], w0 = swarm.angularVelocity[drone];
+        const glm::vec4 t0 = swarm.rotorSpeed[drone];
+        const MotorCurve& curve = swarm.motorCurve;
+
+        // Each block of MPPI_LANES samples is rolled out over the whole horizon
+        // with its state in local arrays, so every per-lane loop below is a
+        // straight SIMD loop with no aliasing between state components.
+        for (size_t k0 = 0; k0 < K; k0 += MPPI_LANES) {
+            float px[MPPI_LANES], py[MPPI_LANES], pz[MPPI_LANES];
+            float vx[MPPI_LANES], vy[MPPI_LANES], vz[MPPI_LANES];
+            float qw[MPPI_LANES], qx[MPPI_LANES], qy[MPPI_LANES], qz[MPPI_LANES];
+            float ww[MPPI_LANES], wx[MPPI_LANES], wy[MPPI_LANES], wz[MPPI_LANES];
+            float speed[SWARM_PROPELLER_COUNT][MPPI_LANES];
+            float cost[MPPI_LANES];
+
+            for (size_t l = 0; l < MPPI_LANES; ++l) {
+                px[l] = p0.x; py[l] = p0.y; pz[l] = p0.z;
+                vx[l] = v0.x; vy[l] = v0.y; vz[l] = v0.z;
+                qw[l] = q0.w; qx[l] = q0.x; qy[l] = q0.y; qz[l] = q0.z;
+                ww[l] = w0.w; wx[l] = w0.x; wy[l] = w0.y; wz[l] = w0.z;
+                for (size_t p = 0; p < P; ++p) speed[p][l] = t0[p];
+                cost[l] = 0.0f;
+            }
+
+            for (size_t h = 0; h < H; ++h) {
+                float total[MPPI_LANES] = {}, tbx[MPPI_LANES] = {}, tbz[MPPI_LANES] = {};
+                float spinY[MPPI_LANES] = {}, effort[MPPI_LANES] = {};
+
+                for (size_t p = 0; p < P; ++p) {
+                    const float base = u[h * P + p];
+                    const float* e = w.noise.data() + (h * P + p) * K + k0;
+                    for (size_t l = 0; l < MPPI_LANES; ++l) {
+                        float cmd = base + e[l];
+                        cmd = cmd < 0.0f ? 0.0f : (cmd > 1.0f ? 1.0f : cmd);
+                        // As in Swarm::update, forces come from the rotor speed
+                        // before this step's command is applied to the motor.
+                        float s = speed[p][l];
+                        float f = MotorCurve::lookup(curve.thrust, s) * maxThrust;
+                        total[l] += f;
+                        tbx[l] += f * armX[p];
+                        tbz[l] += f * armZ[p];
+                        spinY[l] += MotorCurve::lookup(curve.torque, s) * spin[p];
+                        speed[p][l] = s + (cmd - s) * motorResponse * dt;
+                        float d = cmd - config.hoverThrust;
+                        effort[l] += d * d;
+                    }
+                }
+
+                for (size_t l = 0; l < MPPI_LANES; ++l) {
+                    float a = qw[l], b = qx[l], c = qy[l], d = qz[l];
+
+                    // Columns of the rotation matrix needed for up and the torque arm.
+                    float ux = 2.0f * (b * c - a * d);
+                    float uy = 1.0f - 2.0f * (b * b + d * d);
+                    float uz = 2.0f * (c * d + a * b);
+                    float rxx = 1.0f - 2.0f * (c * c + d * d), rxy = 2.0f * (b * c + a * d), rxz = 2.0f * (b * d - a * c);
+                    float rzx = 2.0f * (b * d + a * c), rzy = 2.0f * (c * d - a * b), rzz = 1.0f - 2.0f * (b * b + c * c);
+
+                    vx[l] = (vx[l] + total[l] * ux * invMass * dt) * damping + windDrag.x;
+                    vy[l] = (vy[l] + (total[l] * uy * invMass + gravityAccel) * dt) * damping + windDrag.y;
+                    vz[l] = (vz[l] + total[l] * uz * invMass * dt) * damping + windDrag.z;
+                    px[l] += vx[l] * dt;
+                    py[l] += vy[l] * dt;
+                    pz[l] += vz[l] * dt;
+
+                    float tx = rxx * tbx[l] + rzx * tbz[l];
+                    float ty = rxy * tbx[l] + rzy * tbz[l] + spinY[l];
+                    float tz = rxz * tbx[l] + rzz * tbz[l];
+
+                    float aw = ww[l];
+                    float awx = wx[l] + tx * invInertia.x * dt;
+                    float awy = wy[l] + ty * invInertia.y * dt;
+                    float awz = wz[l] + tz * invInertia.z * dt;
+                    float len2 = aw * aw + awx * awx + awy * awy + awz * awz;
+                    // glm::normalize maps a zero quaternion to identity; all
+                    // components are zero then, so adding `zero` to w suffices.
+                    float inv = inverseSqrt(len2 + 1e-30f);
+                    float zero = len2 > 0.0f ? 0.0f : 1.0f;
+                    aw = aw * inv + zero;
+                    awx *= inv; awy *= inv; awz *= inv;
+                    ww[l] = aw; wx[l] = awx; wy[l] = awy; wz[l] = awz;
+
+                    float s = 0.5f * dt;
+                    float na = a + s * (aw * a - awx * b - awy * c - awz * d);
+                    float nb = b + s * (aw * b + awx * a + awy * d - awz * c);
+                    float nc = c + s * (aw * c - awx * d + awy * a + awz * b);
+                    float nd = d + s * (aw * d + awx * c - awy * b + awz * a);
+                    float qinv = inverseSqrt(na * na + nb * nb + nc * nc + nd * nd);
+                    qw[l] = na * qinv; qx[l] = nb * qinv; qy[l] = nc * qinv; qz[l] = nd * qinv;
+
+                    float ex = target.x - px[l], ey = target.y - py[l], ez = target.z - pz[l];
+                    cost[l] += config.positionWeight * (ex * ex + ey * ey + ez * ez)
+                             + config.velocityWeight * (vx[l] * vx[l] + vy[l] * vy[l] + vz[l] * vz[l])
+                             + config.uprightWeight * (1.0f - uy)
+                             + config.controlWeight * effort[l];
+                }
+            }
+
+            for (size_t l = 0; l < MPPI_LANES; ++l)
+                w.cost[k0 + l] = cost[l];
+        }
+
+        float minCost = *std::min_element(w.cost.begin(), w.cost.begin() + K);
+        float invLambda = 1.0f / config.lambda;
+        float weightSum = 0.0f;
+        for (size_t k = 0; k < K; ++k) {
+            w.cost[k] = std::exp(-(w.cost[k] - minCost) * invLambda);
+            weightSum += w.cost[k];
+        }
+
+        float invSum = 1.0f / weightSum;
+        for (size_t h = 0; h < H; ++h) {
+            for (size_t p = 0; p < P; ++p) {
+                float delta = 0.0f;
+                for (size_t k = 0; k < K; ++k)
+                    delta += w.cost[k] * w.noise[(h * P + p) * K + k];
+                u[h * P + p] = std::min(std::max(u[h * P + p] + delta * invSum, 0.0f), 1.0f);
+            }
+        }
+
+        swarm.setPropellerThrusts(drone, glm::vec4(u[0], u[1], u[2], u[3]));
+
+        std::copy(u + P, u + H * P, u);
+        std::fill(u + (H - 1) * P, u + H * P, config.hoverThrust);
+    }
+};
@@ -0,0 +1,474 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "occupancy_map.hpp"
+#include "thread_pool.hpp"
+
+#define PLANNER_HISTOGRAM_BUCKETS 32
+
+// Longest jump before a jump point is made anyway. Diagonal jumps probe
+// every sub-direction at each step, so unbounded jumps across open space
+// cost O(L^3); extra jump points never break optimality.
+#ifndef PLANNER_MAX_JUMP
+    #define PLANNER_MAX_JUMP 16
+#endif
+
+enum PlannerMode {
+    PLANNER_ASTAR,
+    PLANNER_JPS
+};
+
+struct PlanRequest {
+    glm::vec3 start;
+    glm::vec3 goal;
+};
+
+struct PlanResult {
+    bool found = false;
+    std::vector<glm::vec3> path;    // start, turning points, goal
+    float cost = 0.0f;              // world units
+    size_t expansions = 0;
+    double seconds = 0.0;
+};
+
+// Plan latencies in power-of-two microsecond buckets: bucket b holds
+// latencies in [2^(b-1), 2^b) us, bucket 0 anything under 1 us.
+struct LatencyHistogram {
+    size_t buckets[PLANNER_HISTOGRAM_BUCKETS] = {};
+    size_t count = 0;
+    double total = 0.0;
+    double worst = 0.0;
+
+    void record(double seconds) {
+        double us = seconds * 1e6;
+        int b = 0;
+        while (b < PLANNER_HISTOGRAM_BUCKETS - 1 && us >= double(1u << b)) ++b;
+        ++buckets[b];
+        ++count;
+        total += seconds;
+        worst = std::max(worst, seconds);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int b = 0; b < PLANNER_HISTOGRAM_BUCKETS; ++b) buckets[b] += other.buckets[b];
+        count += other.count;
+        total += other.total;
+        worst = std::max(worst, other.worst);
+    }
+
+    double mean() const { return count ? total / double(count) : 0.0; }
+
+    // Upper edge, in seconds, of the bucket holding the given fraction.
+    double percentile(double fraction) const {
+        size_t target = size_t(std::ceil(fraction * double(count))), seen = 0;
+        for (int b = 0; b < PLANNER_HISTOGRAM_BUCKETS; ++b) {
+            seen += buckets[b];
+            if (seen >= target && seen > 0) return std::min(double(1u << b) * 1e-6, worst);
+        }
+        return worst;
+    }
+};
+
+// 26-connected grid planner over the voxels of an OccupancyMap inside a
+// bounding box. At construction the occupied voxels are dilated by the
+// drone clearance into a dense bitset, plus a second bitset marking cells
+// with a blocked cell among their 26 neighbours; after that a plan never
+// touches the hash map, and every worker searches in its own scratch
+// (generation-stamped, so resetting it is free). The open list and the
+// caller's path keep their capacity between plans, so once a worker has
+// run a search of a given size, later searches no larger do not allocate.
+//
+// PLANNER_ASTAR expands all 26 neighbours. PLANNER_JPS is jump point search
+// with per-direction pruning tables built once from the canonical path
+// order (see PruneTables); cells away from obstacles use the precomputed
+// natural successors, so only cells next to obstacles read the grid. Both
+// return optimal octile-cost paths.
+class GridPlanner {
+public:
+    // `workers` is the number of scratches, one per concurrent plan() caller;
+    // match it to the pool passed to planBatch, which otherwise adds the
+    // missing scratches on its first call.
+    GridPlanner(const OccupancyMap& map, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                float clearance = 0.0f, unsigned int workers = 1, size_t _maxExpansions = 1u << 20)
+        : voxelSize(map.voxelSize), origin(map.origin), maxExpansions(_maxExpansions)
+    {
+        low = map.toVoxel(boundsMin);
+        dims = map.toVoxel(boundsMax) - low + 1;
+        cellCount = size_t(dims.x) * dims.y * dims.z;
+
+        std::vector<uint64_t> occupied((cellCount + 63) / 64, 0);
+        for (int z = 0; z < dims.z; ++z)
+            for (int y = 0; y < dims.y; ++y)
+                for (int x = 0; x < dims.x; ++x)
+                    if (map.isOccupied(low + glm::ivec3(x, y, z))) setBit(occupied, index(x, y, z));
+
+        int radius = int(std::ceil(clearance / voxelSize));
+        blocked = dilate(occupied, radius);
+        nearBlocked = dilate(blocked, 1);
+        // Outside the grid counts as blocked, so border cells are never clear.
+        for (int z = 0; z < dims.z; ++z)
+            for (int y = 0; y < dims.y; ++y)
+                for (int x = 0; x < dims.x; ++x)
+                    if (x == 0 || y == 0 || z == 0 || x == dims.x - 1 || y == dims.y - 1 || z == dims.z - 1)
+                        setBit(nearBlocked, index(x, y, z));
+
+        addScratch(std::max(1u, workers));
+    }
+
+    size_t workerCount() const { return scratch.size(); }
+    const glm::ivec3& getDims() const { return dims; }
+
+    bool isBlocked(const glm::vec3& pos) const {
+        glm::ivec3 c = toCell(pos);
+        return !inside(c) || testBit(blocked, index(c.x, c.y, c.z));
+    }
+
+    // Plans on the given worker's scratch; concurrent calls must use
+    // different workers.
+    bool plan(const glm::vec3& start, const glm::vec3& goal, PlanResult& result,
+              PlannerMode mode = PLANNER_JPS, unsigned int worker = 0) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        result.found = search(start, goal, result, mode, scratch[worker]);
+        result.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - T0).count();
+        scratch[worker].latency.record(result.seconds);
+        return result.found;
+    }
+
+    // Serves a batch of requests across the pool, one search per request.
+    void planBatch(const std::vector<PlanRequest>& requests, std::vector<PlanResult>& results,
+                   ThreadPool* pool = nullptr, PlannerMode mode = PLANNER_JPS) {
+        results.resize(requests.size());
+        auto range = [&](size_t begin, size_t end, unsigned int worker) {
+            for (size_t i = begin; i < end; ++i)
+                plan(requests[i].start, requests[i].goal, results[i], mode, worker);
+        };
+        if (pool) {
+            if (pool->size() > scratch.size()) addScratch(pool->size());
+            pool->parallelFor(requests.size(), range, 1);
+        }
+        else range(0, requests.size(), 0);
+    }
+
+    LatencyHistogram latency() const {
+        LatencyHistogram merged;
+        for (const Scratch& s : scratch) merged.merge(s.latency);
+        return merged;
+    }
+
+    void resetLatency() {
+        for (Scratch& s : scratch) s.latency = LatencyHistogram();
+    }
+
+private:
+    struct HeapEntry {
+        float f;
+        uint32_t cell;
+        bool operator<(const HeapEntry& other) const { return f > other.f; }
+    };
+
+    struct Scratch {
+        std::vector<uint32_t> stamp;    // generation * 2 = open, + 1 = closed
+        std::vector<float> g;
+        std::vector<uint32_t> parent;
+        std::vector<uint8_t> arrival;   // direction index, 13 = start
+        std::vector<HeapEntry> open;
+        uint32_t generation;
+        LatencyHistogram latency;
+    };
+
+    float voxelSize;
+    glm::vec3 origin;
+    size_t maxExpansions;
+
+    glm::ivec3 low;
+    glm::ivec3 dims;
+    size_t cellCount;
+    std::vector<uint64_t> blocked;
+    std::vector<uint64_t> nearBlocked;
+    std::vector<Scratch> scratch;
+
+    static void setBit(std::vector<uint64_t>& bits, size_t i) { bits[i >> 6] |= uint64_t(1) << (i & 63); }
+    static bool testBit(const std::vector<uint64_t>& bits, size_t i) { return (bits[i >> 6] >> (i & 63)) & 1; }
+
+    // Grows the scratch list to `count` workers; existing scratches and their
+    // latency histograms are kept.
+    void addScratch(size_t count) {
+        for (size_t w = scratch.size(); w < count; ++w) {
+            Scratch s;
+            s.stamp.assign(cellCount, 0);
+            s.g.resize(cellCount);
+            s.parent.resize(cellCount);
+            s.arrival.resize(cellCount);
+            s.open.reserve(1024);    // grows to the largest search, then stays
+            s.generation = 0;
+            scratch.push_back(std::move(s));
+        }
+    }
+
+    size_t index(int x, int y, int z) const { return (size_t(z) * dims.y + y) * dims.x + x; }
+
+    glm::ivec3 cellOf(size_t i) const {
+        return glm::ivec3(int(i % dims.x), int((i / dims.x) % dims.y), int(i / (size_t(dims.x) * dims.y)));
+    }
+
+    bool inside(const glm::ivec3& c) const {
+        return c.x >= 0 && c.y >= 0 && c.z >= 0 && c.x < dims.x && c.y < dims.y && c.z < dims.z;
+    }
+
+    glm::ivec3 toCell(const glm::vec3& pos) const {
+        return glm::ivec3(glm::floor((pos - origin) / voxelSize)) - low;
+    }
+
+    glm::vec3 cellCenter(const glm::ivec3& c) const {
+        return origin + (glm::vec3(c + low) + 0.5f) * voxelSize;
+    }
+
+    bool free(const glm::ivec3& c) const { return inside(c) && !testBit(blocked, index(c.x, c.y, c.z)); }
+    bool clearAround(const glm::ivec3& c) const { return inside(c) && !testBit(nearBlocked, index(c.x, c.y, c.z)); }
+
+    // Cells within `radius` (Chebyshev) of a set bit, by three separable
+    // running-window passes.
+    std::vector<uint64_t> dilate(const std::vector<uint64_t>& bits, int radius) const {
+        if (radius <= 0) return bits;
+        std::vector<uint64_t> current = bits, next(bits.size());
+        for (int axis = 0; axis < 3; ++axis) {
+            std::fill(next.begin(), next.end(), 0);
+            int length = dims[axis];
+            for (int z = 0; z < dims.z; ++z)
+                for (int y = 0; y < dims.y; ++y)
+                    for (int x = 0; x < dims.x; ++x) {
+                        glm::ivec3 c(x, y, z);
+                        if (c[axis] != 0) continue;
+                        // Walk the line along `axis`, counting set bits in the window.
+                        int count = 0;
+                        for (int k = 0; k < std::min(radius, length); ++k) {
+                            c[axis] = k;
+                            count += testBit(current, index(c.x, c.y, c.z));
+                        }
+                        for (int k = 0; k < length; ++k) {
+                            c[axis] = k + radius;
+                            if (k + radius < length) count += testBit(current, index(c.x, c.y, c.z));
+                            c[axis] = k - radius - 1;
+                            if (k - radius - 1 >= 0) count -= testBit(current, index(c.x, c.y, c.z));
+                            c[axis] = k;
+                            if (count > 0) setBit(next, index(c.x, c.y, c.z));
+                        }
+                    }
+            current.swap(next);
+        }
+        return current;
+    }
+
+    static glm::ivec3 direction(int d) { return glm::ivec3(d % 3 - 1, (d / 3) % 3 - 1, d / 9 - 1); }
+    static int directionIndex(const glm::ivec3& d) { return (d.z + 1) * 9 + (d.y + 1) * 3 + (d.x + 1); }
+
+    static float stepCost(const glm::ivec3& d) {
+        static const float costs[4] = {0.0f, 1.0f, 1.41421356f, 1.73205081f};
+        return costs[std::abs(d.x) + std::abs(d.y) + std::abs(d.z)];
+    }
+
+    // Octile distance in 3D, in cells.
+    static float heuristic(const glm::ivec3& a, const glm::ivec3& b) {
+        glm::ivec3 d = glm::abs(a - b);
+        int hi = std::max(std::max(d.x, d.y), d.z);
+        int lo = std::min(std::min(d.x, d.y), d.z);
+        int mid = d.x + d.y + d.z - hi - lo;
+        return 1.73205081f * float(lo) + 1.41421356f * float(mid - lo) + float(hi - mid);
+    }
+
+    // Pruning tables for arrival direction a and candidate direction b,
+    // from cell x reached from p = x - a. Moving on to n = x + b is
+    // redundant if n is adjacent to p, or if some other path p -> y -> n is
+    // shorter or equally short and earlier in the canonical order (larger
+    // first move, then lower direction index). `alternatives` lists those y
+    // as offsets from x; n is a successor only while all of them are
+    // blocked. `natural` is the successor set when nothing is blocked.
+    struct PruneTables {
+        uint32_t natural[27];
+        uint32_t adjacent[27];
+        std::vector<glm::ivec3> alternatives[27][27];
+
+        PruneTables() {
+            for (int a = 0; a < 27; ++a) {
+                natural[a] = adjacent[a] = 0;
+                if (a == 13) continue;
+                glm::ivec3 p = -direction(a);
+                for (int b = 0; b < 27; ++b) {
+                    if (b == 13) continue;
+                    glm::ivec3 n = direction(b);
+                    glm::ivec3 reach = glm::abs(n - p);
+                    if (std::max(std::max(reach.x, reach.y), reach.z) <= 1) {
+                        adjacent[a] |= 1u << b;
+                        continue;
+                    }
+                    float via = stepCost(direction(a)) + stepCost(n);
+                    for (int y = 0; y < 125; ++y) {
+                        glm::ivec3 o(y % 5 - 2, (y / 5) % 5 - 2, y / 25 - 2);
+                        glm::ivec3 first = o - p, second = n - o;
+                        if (o == glm::ivec3(0) || o == p || o == n) continue;
+                        if (glm::any(glm::greaterThan(glm::abs(first), glm::ivec3(1))) ||
+                            glm::any(glm::greaterThan(glm::abs(second), glm::ivec3(1)))) continue;
+                        float alt = stepCost(first) + stepCost(second);
+                        int firstMoving = moving(first), arrivalMoving = moving(direction(a));
+                        bool earlier = firstMoving > arrivalMoving ||
+                                       (firstMoving == arrivalMoving && directionIndex(first) < a);
+                        if (alt < via - 1e-4f || (alt < via + 1e-4f && earlier))
+                            alternatives[a][b].push_back(o);
+                    }
+                    if (alternatives[a][b].empty()) natural[a] |= 1u << b;
+                }
+            }
+        }
+    };
+
+    static const PruneTables& pruneTables() {
+        static const PruneTables tables;
+        return tables;
+    }
+
+    static int moving(const glm::ivec3& d) { return std::abs(d.x) + std::abs(d.y) + std::abs(d.z); }
+
+    // Successor directions of `c` reached along arrival direction `a`,
+    // among `candidates`. Cells whose neighbourhood, and their
+    // predecessor's, is clear take the natural set without looking at the
+    // grid.
+    uint32_t successors(const glm::ivec3& c, int a, uint32_t candidates) const {
+        const PruneTables& t = pruneTables();
+        if (clearAround(c) && clearAround(c - direction(a))) return t.natural[a] & candidates;
+        candidates &= ~t.adjacent[a] & ~(1u << 13);
+        uint32_t mask = 0;
+        for (int b = 0; b < 27; ++b) {
+            if (!((candidates >> b) & 1) || !free(c + direction(b))) continue;
+            bool redundant = false;
+            for (const glm::ivec3& o : t.alternatives[a][b])
+                if (free(c + o)) {
+                    redundant = true;
+                    break;
+                }
+            if (!redundant) mask |= 1u << b;
+        }
+        return mask;
+    }
+
+    // Steps from `c` along direction `a` until reaching a cell worth
+    // expanding: the goal, a cell with a forced (non-natural) successor, or
+    // for diagonal moves a cell from which a natural sub-direction reaches
+    // one. Returns false if the line runs into a blocked cell or leaves the
+    // grid first.
+    bool jump(glm::ivec3 c, int a, const glm::ivec3& goal, glm::ivec3& out, int& steps) const {
+        const PruneTables& t = pruneTables();
+        glm::ivec3 d = direction(a);
+        steps = 0;
+        while (true) {
+            c += d;
+            ++steps;
+            if (!free(c)) return false;
+            if (c == goal || steps >= PLANNER_MAX_JUMP || successors(c, a, ~t.natural[a])) {
+                out = c;
+                return true;
+            }
+            if (moving(d) > 1) {
+                uint32_t subs = t.natural[a] & ~(1u << a);
+                for (int b = 0; b < 27; ++b) {
+                    if (!((subs >> b) & 1)) continue;
+                    glm::ivec3 found;
+                    int subSteps;
+                    if (jump(c, b, goal, found, subSteps)) {
+                        out = c;
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    bool search(const glm::vec3& startPos, const glm::vec3& goalPos, PlanResult& result, PlannerMode mode, Scratch& s) {
+        result.path.clear();
+        result.cost = 0.0f;
+        result.expansions = 0;
+
+        glm::ivec3 start = toCell(startPos), goal = toCell(goalPos);
+        if (!free(start) || !free(goal)) return false;
+
+        // Two stamps per search; on wrap-around the stamps are cleared.
+        s.generation += 1;
+        if (s.generation >= 0x7fffffffu) {
+            std::fill(s.stamp.begin(), s.stamp.end(), 0);
+            s.generation = 1;
+        }
+        const uint32_t openStamp = s.generation * 2, closedStamp = s.generation * 2 + 1;
+        s.open.clear();
+
+        size_t startIndex = index(start.x, start.y, start.z), goalIndex = index(goal.x, goal.y, goal.z);
+        s.stamp[startIndex] = openStamp;
+        s.g[startIndex] = 0.0f;
+        s.parent[startIndex] = uint32_t(startIndex);
+        s.arrival[startIndex] = 13;
+        s.open.push_back({heuristic(start, goal), uint32_t(startIndex)});
+
+        while (!s.open.empty()) {
+            std::pop_heap(s.open.begin(), s.open.end());
+            HeapEntry top = s.open.back();
+            s.open.pop_back();
+            size_t current = top.cell;
+            if (s.stamp[current] == closedStamp) continue;
+            s.stamp[current] = closedStamp;
+
+            if (current == goalIndex) {
+                buildPath(s, startIndex, goalIndex, startPos, goalPos, result);
+                return true;
+            }
+            if (++result.expansions > maxExpansions) return false;
+
+            glm::ivec3 c = cellOf(current);
+            uint32_t expand = 0x7ffffffu & ~(1u << 13);
+            if (mode == PLANNER_JPS && s.arrival[current] != 13) expand = successors(c, s.arrival[current], expand);
+
+            for (int k = 0; k < 27; ++k) {
+                if (!((expand >> k) & 1)) continue;
+                glm::ivec3 d = direction(k);
+
+                glm::ivec3 next;
+                int steps = 1;
+                if (mode == PLANNER_JPS) {
+                    if (!jump(c, k, goal, next, steps)) continue;
+                } else {
+                    next = c + d;
+                    if (!free(next)) continue;
+                }
+
+                size_t n = index(next.x, next.y, next.z);
+                if (s.stamp[n] == closedStamp) continue;
+                float g = s.g[current] + stepCost(d) * float(steps);
+                if (s.stamp[n] == openStamp && g >= s.g[n]) continue;
+
+                s.stamp[n] = openStamp;
+                s.g[n] = g;
+                s.parent[n] = uint32_t(current);
+                s.arrival[n] = uint8_t(k);
+                s.open.push_back({g + heuristic(next, goal), uint32_t(n)});
+                std::push_heap(s.open.begin(), s.open.end());
+            }
+        }
+        return false;
+    }
+
+    // Walks parents back from the goal. Jump points are joined by straight
+    // lines, so they are the only waypoints needed.
+    void buildPath(const Scratch& s, size_t startIndex, size_t goalIndex, const glm::vec3& startPos,
+                   const glm::vec3& goalPos, PlanResult& result) const {
+        result.path.push_back(goalPos);
+        for (size_t i = s.parent[goalIndex]; i != startIndex; i = s.parent[i])
+            result.path.push_back(cellCenter(cellOf(i)));
+        result.path.push_back(startPos);
+        std::reverse(result.path.begin(), result.path.end());
+        result.cost = s.g[goalIndex] * voxelSize;
+    }
+};
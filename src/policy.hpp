@@ -0,0 +1,272 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+#include "drone.hpp"
+
+#define POLICY_OBSERVATION_SIZE 14
+#define POLICY_ACTION_SIZE      4
+
+#ifndef POLICY_BLOCK_ROWS
+    #define POLICY_BLOCK_ROWS 4
+#endif
+
+#ifndef POLICY_BLOCK_COLS
+    #define POLICY_BLOCK_COLS 8
+#endif
+
+#ifndef POLICY_POSITION_SCALE
+    #define POLICY_POSITION_SCALE 0.02f
+#endif
+
+#ifndef POLICY_VELOCITY_SCALE
+    #define POLICY_VELOCITY_SCALE 0.05f
+#endif
+
+// Multi-layer perceptron evaluated for a whole batch of drones at once.
+// Activations are stored row-major (one row per drone) with every row padded
+// to a multiple of POLICY_BLOCK_COLS, so each layer is a blocked GEMM whose
+// inner loop is a fixed-width run the compiler turns into SIMD code.
+// With shared weights all rows use one parameter set; otherwise every drone
+// owns a parameter set and each layer degenerates to a batch of GEMVs.
+class PolicyNetwork {
+public:
+    PolicyNetwork(const std::vector<int>& _layerSizes, size_t _batchSize, bool _sharedWeights = true)
+        : layerSizes(_layerSizes), batchSize(_batchSize), sharedWeights(_sharedWeights),
+          totalInferences(0), totalSeconds(0.0), lastSeconds(0.0)
+    {
+        // packObservation() fills the input row and applyActions() reads the
+        // output row, so both ends of the network are fixed.
+        if (layerSizes.size() < 2 || layerSizes.front() != POLICY_OBSERVATION_SIZE ||
+            layerSizes.back() != POLICY_ACTION_SIZE) {
+            std::cerr << "Error: Policy layers must run from " << POLICY_OBSERVATION_SIZE << " inputs to "
+                      << POLICY_ACTION_SIZE << " outputs.\n";
+            std::exit(-1);
+        }
+        for (int size : layerSizes) {
+            if (size <= 0) {
+                std::cerr << "Error: Policy layer sizes must be positive.\n";
+                std::exit(-1);
+            }
+        }
+
+        size_t widest = 0;
+        size_t offset = 0;
+        logicalCount = 0;
+        for (size_t l = 0; l + 1 < layerSizes.size(); ++l) {
+            Layer layer;
+            layer.inSize = layerSizes[l];
+            layer.outSize = layerSizes[l + 1];
+            layer.inStride = padded(layer.inSize);
+            layer.outStride = padded(layer.outSize);
+            layer.weightOffset = offset;
+            offset += layer.inSize * layer.outStride;
+            layer.biasOffset = offset;
+            offset += layer.outStride;
+            layers.push_back(layer);
+
+            logicalCount += layer.inSize * layer.outSize + layer.outSize;
+            widest = std::max(widest, std::max(layer.inStride, layer.outStride));
+        }
+        paddedCount = offset;
+        parameters.assign(paddedCount * (sharedWeights ? 1 : batchSize), 0.0f);
+
+        bufferStride = widest;
+        buffers[0].assign(batchSize * bufferStride, 0.0f);
+        buffers[1].assign(batchSize * bufferStride, 0.0f);
+    }
+
+    float* observations() { return buffers[0].data(); }
+    size_t observationStride() const { return bufferStride; }
+
+    const float* actions() const { return buffers[layers.size() % 2].data(); }
+    size_t actionStride() const { return bufferStride; }
+
+    size_t getBatchSize() const { return batchSize; }
+    size_t parameterCount() const { return logicalCount; }
+    size_t instanceCount() const { return sharedWeights ? 1 : batchSize; }
+
+    void setParameters(const float* values, size_t instance = 0) {
+        float* dst = parameters.data() + instance * paddedCount;
+        for (const auto& layer : layers) {
+            for (size_t i = 0; i < layer.inSize; ++i)
+                for (size_t o = 0; o < layer.outSize; ++o)
+                    dst[layer.weightOffset + i * layer.outStride + o] = *values++;
+            for (size_t o = 0; o < layer.outSize; ++o)
+                dst[layer.biasOffset + o] = *values++;
+        }
+    }
+
+    void getParameters(float* values, size_t instance = 0) const {
+        const float* src = parameters.data() + instance * paddedCount;
+        for (const auto& layer : layers) {
+            for (size_t i = 0; i < layer.inSize; ++i)
+                for (size_t o = 0; o < layer.outSize; ++o)
+                    *values++ = src[layer.weightOffset + i * layer.outStride + o];
+            for (size_t o = 0; o < layer.outSize; ++o)
+                *values++ = src[layer.biasOffset + o];
+        }
+    }
+
+    void randomize(std::mt19937& rng, float scale = 1.0f) {
+        std::vector<float> values(logicalCount);
+        for (size_t n = 0; n < instanceCount(); ++n) {
+            size_t v = 0;
+            for (const auto& layer : layers) {
+                std::normal_distribution<float> dist(0.0f, scale / std::sqrt(float(layer.inSize)));
+                for (size_t i = 0; i < layer.inSize * layer.outSize; ++i)
+                    values[v++] = dist(rng);
+                for (size_t o = 0; o < layer.outSize; ++o)
+                    values[v++] = 0.0f;
+            }
+            setParameters(values.data(), n);
+        }
+    }
+
+    void evaluate() { evaluate(batchSize); }
+
+    void evaluate(size_t rows) {
+        rows = std::min(rows, batchSize);
+        auto T0 = std::chrono::high_resolution_clock::now();
+
+        for (size_t l = 0; l < layers.size(); ++l) {
+            const Layer& layer = layers[l];
+            const float* in = buffers[l % 2].data();
+            float* out = buffers[(l + 1) % 2].data();
+            bool hidden = l + 1 < layers.size();
+
+            if (sharedWeights) {
+                denseLayer(layer, parameters.data(), in, out, rows);
+            } else {
+                for (size_t r = 0; r < rows; ++r)
+                    denseLayer(layer, parameters.data() + r * paddedCount,
+                               in + r * bufferStride, out + r * bufferStride, 1);
+            }
+
+            for (size_t r = 0; r < rows; ++r) {
+                float* row = out + r * bufferStride;
+                if (hidden) {
+                    for (size_t o = 0; o < layer.outStride; ++o)
+                        row[o] = std::tanh(row[o]);
+                } else {
+                    for (size_t o = 0; o < layer.outStride; ++o)
+                        row[o] = 1.0f / (1.0f + std::exp(-row[o]));
+                }
+            }
+        }
+
+        auto T1 = std::chrono::high_resolution_clock::now();
+        lastSeconds = std::chrono::duration<double>(T1 - T0).count();
+        totalSeconds += lastSeconds;
+        totalInferences += rows;
+    }
+
+    double inferencesPerSecond() const {
+        return totalSeconds > 0.0 ? double(totalInferences) / totalSeconds : 0.0;
+    }
+
+    double lastEvaluationSeconds() const { return lastSeconds; }
+
+    void resetStats() {
+        totalInferences = 0;
+        totalSeconds = 0.0;
+    }
+
+private:
+    struct Layer {
+        size_t inSize, outSize;
+        size_t inStride, outStride;
+        size_t weightOffset, biasOffset;
+    };
+
+    std::vector<int> layerSizes;
+    std::vector<Layer> layers;
+    size_t batchSize;
+    bool sharedWeights;
+
+    std::vector<float> parameters;
+    size_t paddedCount;
+    size_t logicalCount;
+
+    std::vector<float> buffers[2];
+    size_t bufferStride;
+
+    size_t totalInferences;
+    double totalSeconds;
+    double lastSeconds;
+
+    static size_t padded(size_t n) {
+        return (n + POLICY_BLOCK_COLS - 1) / POLICY_BLOCK_COLS * POLICY_BLOCK_COLS;
+    }
+
+    void denseLayer(const Layer& layer, const float* params, const float* in, float* out, size_t rows) const {
+        const float* W = params + layer.weightOffset;
+        const float* b = params + layer.biasOffset;
+
+        for (size_t r0 = 0; r0 < rows; r0 += POLICY_BLOCK_ROWS) {
+            size_t rn = std::min<size_t>(rows - r0, POLICY_BLOCK_ROWS);
+
+            for (size_t c0 = 0; c0 < layer.outStride; c0 += POLICY_BLOCK_COLS) {
+                float acc[POLICY_BLOCK_ROWS][POLICY_BLOCK_COLS];
+                for (size_t r = 0; r < POLICY_BLOCK_ROWS; ++r)
+                    for (size_t c = 0; c < POLICY_BLOCK_COLS; ++c)
+                        acc[r][c] = b[c0 + c];
+
+                for (size_t k = 0; k < layer.inSize; ++k) {
+                    const float* w = W + k * layer.outStride + c0;
+                    for (size_t r = 0; r < rn; ++r) {
+                        float x = in[(r0 + r) * bufferStride + k];
+                        for (size_t c = 0; c < POLICY_BLOCK_COLS; ++c)
+                            acc[r][c] += x * w[c];
+                    }
+                }
+
+                for (size_t r = 0; r < rn; ++r)
+                    for (size_t c = 0; c < POLICY_BLOCK_COLS; ++c)
+                        out[(r0 + r) * bufferStride + c0 + c] = acc[r][c];
+            }
+        }
+    }
+};
+
+inline void packObservation(float* row, const glm::vec3& target, const glm::vec3& position, const glm::quat& rotation,
+                            const glm::vec3& velocity, const glm::quat& angularVelocity) {
+    glm::vec3 error = (target - position) * POLICY_POSITION_SCALE;
+    glm::vec3 vel = velocity * POLICY_VELOCITY_SCALE;
+
+    row[0]  = error.x;           row[1]  = error.y;           row[2]  = error.z;
+    row[3]  = rotation.w;        row[4]  = rotation.x;        row[5]  = rotation.y;        row[6]  = rotation.z;
+    row[7]  = vel.x;             row[8]  = vel.y;             row[9]  = vel.z;
+    row[10] = angularVelocity.w; row[11] = angularVelocity.x; row[12] = angularVelocity.y; row[13] = angularVelocity.z;
+}
+
+inline void gatherObservations(PolicyNetwork& policy, const std::vector<std::unique_ptr<Drone>>& drones,
+                               const glm::vec3& target) {
+    float* obs = policy.observations();
+    size_t stride = policy.observationStride();
+    size_t count = std::min(drones.size(), policy.getBatchSize());
+
+    for (size_t i = 0; i < count; ++i) {
+        const Drone& d = *drones[i];
+        packObservation(obs + i * stride, target, d.position, d.rotation, d.velocity, d.angularVelocity);
+    }
+}
+
+inline void applyActions(const PolicyNetwork& policy, std::vector<std::unique_ptr<Drone>>& drones) {
+    const float* act = policy.actions();
+    size_t stride = policy.actionStride();
+    size_t count = std::min(drones.size(), policy.getBatchSize());
+
+    for (size_t i = 0; i < count; ++i)
+        drones[i]->setPropellerThrusts(act + i * stride);
+}
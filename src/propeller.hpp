@@ -3,6 +3,8 @@
 #include "mesh.hpp"
 #include "box_collider.hpp"
 
+#include "motor.hpp"
+
 #define PROPELLER_TYPE_CW  0
 #define PROPELLER_TYPE_CCW 1
 
@@ -17,7 +19,11 @@ public:
     unsigned int type;
     float spinAngle;
     float targetThrust;
+    float rotorSpeed;
     float thrust;
+    float torque;
+    float motorResponse;
+    const MotorCurve* motorCurve;
 
     Propeller(unsigned int _type, const std::unique_ptr<Mesh>& _droneMesh, glm::vec3 _relPos,
               glm::quat _relRot, float _scale, glm::vec3 _color)
@@ -39,13 +45,19 @@ public:
 
         spinAngle = 0.0f;
         targetThrust = 0.0f;
+        rotorSpeed = 0.0f;
         thrust = 0.0f;
+        torque = 0.0f;
+        motorResponse = 5.0f;
+        motorCurve = &DEFAULT_MOTOR_CURVE;
     }
     
     void update(float deltaTime) {
-        thrust += (targetThrust - thrust) * 5.0f * deltaTime;
+        rotorSpeed += (targetThrust - rotorSpeed) * motorResponse * deltaTime;
+        thrust = motorCurve->thrustAt(rotorSpeed);
+        torque = motorCurve->torqueAt(rotorSpeed);
 
-        spinAngle += ((type == PROPELLER_TYPE_CW)? thrust : -thrust) * 48.0f * deltaTime;
+        spinAngle += ((type == PROPELLER_TYPE_CW)? rotorSpeed : -rotorSpeed) * 48.0f * deltaTime;
         glm::quat spinRot = glm::angleAxis(spinAngle, droneMesh->up);
         glm::quat worldRot = droneMesh->rotation * relRot;
         glm::vec3 worldPos = droneMesh->position + droneMesh->rotation * relPos;
@@ -58,7 +70,9 @@ public:
     void reset() {
         spinAngle = 0.0f;
         targetThrust = 0.0f;
+        rotorSpeed = 0.0f;
         thrust = 0.0f;
+        torque = 0.0f;
 
         glm::quat spinRot = glm::angleAxis(spinAngle, droneMesh->up);
         glm::quat worldRot = droneMesh->rotation * relRot;
@@ -69,7 +83,7 @@ public:
         mesh->setPosition(worldPos);
     }
 
-    void render (Shader shader) {
+    void render (Shader& shader) {
         mesh->render(shader);
     }
 
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "kd_tree.hpp"
+#include "bvh.hpp"
+#include "world.hpp"
+#include "philox.hpp"
+#include "thread_pool.hpp"
+
+// Samples drawn, checked and committed together. The tree is read-only
+// while a batch is checked in parallel, so samples in one batch cannot
+// connect to each other.
+#ifndef RRT_BATCH_SIZE
+    #define RRT_BATCH_SIZE 64
+#endif
+
+#define RRT_MAX_SAMPLE_ATTEMPTS 32
+
+struct RrtConfig {
+    size_t maxSamples = 4000;
+    double timeLimit = 0.0;         // seconds, 0 for no limit
+    float stepSize = 20.0f;         // longest edge added by one sample
+    float clearance = 2.0f;         // half-extent of the box swept along edges
+    float goalBias = 0.05f;
+    float rewireScale = 1.0f;       // multiplies the RRT* gamma constant
+    bool informed = true;
+    uint32_t seed = 1;
+};
+
+struct RrtCostSample {
+    double seconds;
+    size_t samples;
+    float cost;
+};
+
+struct RrtResult {
+    bool found = false;
+    std::vector<glm::vec3> path;    // start, tree nodes, goal
+    float cost = 0.0f;
+    size_t samples = 0;
+    size_t nodes = 0;
+    size_t edgeChecks = 0;
+    double seconds = 0.0;
+    std::vector<RrtCostSample> costOverTime;   // every improvement of the best path
+};
+
+struct RrtStats {
+    size_t plans;
+    size_t solved;
+    double seconds;
+    size_t edgeChecks;
+
+    double plansPerSecond() const { return seconds > 0.0 ? double(plans) / seconds : 0.0; }
+};
+
+// RRT* in continuous space inside a bounding box, with informed sampling
+// once a path is known: samples are then drawn from the ellipsoid of points
+// that could still shorten it. Collisions are tested against a triangle
+// World's BVHs and a set of axis-aligned obstacles (e.g. BoxCollider
+// bounds) kept in their own BVH; an edge is free if a box of half-extent
+// `clearance` swept along it touches neither, tested as a chain of boxes no
+// longer than the clearance.
+//
+// Samples are processed RRT_BATCH_SIZE at a time. Nearest and near-set
+// queries on the k-d tree and every edge check of a batch, for choosing
+// parents and for rewiring, are spread over the pool; the batch is then
+// committed to the tree in sample order, re-testing costs against any
+// rewiring done since the checks.
+class RrtPlanner {
+public:
+    RrtConfig config;
+
+    RrtPlanner(const glm::vec3& _boundsMin, const glm::vec3& _boundsMax, const RrtConfig& _config = RrtConfig())
+        : config(_config), boundsMin(_boundsMin), boundsMax(_boundsMax), world(nullptr), stats{0, 0, 0.0, 0} {}
+
+    // The world is not owned and must outlive this object; nullptr for none.
+    void setWorld(const World* _world) { world = _world; }
+
+    void setObstacles(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs) {
+        obstacleMin = mins;
+        obstacleMax = maxs;
+        obstacles.build(obstacleMin, obstacleMax);
+    }
+
+    const RrtStats& getStats() const { return stats; }
+    void resetStats() { stats = {0, 0, 0.0, 0}; }
+
+    bool isFree(const glm::vec3& p) const {
+        glm::vec3 lo = p - config.clearance, hi = p + config.clearance;
+        return inBounds(p) && !boxBlocked(lo, hi);
+    }
+
+    bool segmentFree(const glm::vec3& a, const glm::vec3& b) const {
+        if (!inBounds(a) || !inBounds(b)) return false;
+        float r = config.clearance;
+        bool hitObstacle = false;
+        obstacles.forEachOverlap(glm::min(a, b) - r, glm::max(a, b) + r, [&](uint32_t k) {
+            hitObstacle = segmentHitsBox(a, b, obstacleMin[k] - r, obstacleMax[k] + r);
+            return !hitObstacle;
+        });
+        if (hitObstacle) return false;
+        if (!world) return true;
+
+        int pieces = std::max(1, int(std::ceil(glm::length(b - a) / std::max(r, 1e-3f))));
+        glm::vec3 from = a;
+        for (int k = 1; k <= pieces; ++k) {
+            glm::vec3 to = k == pieces ? b : a + (b - a) * (float(k) / float(pieces));
+            if (world->overlapsBox(glm::min(from, to) - r, glm::max(from, to) + r)) return false;
+            from = to;
+        }
+        return true;
+    }
+
+    bool plan(const glm::vec3& start, const glm::vec3& goal, RrtResult& result, ThreadPool* pool = nullptr) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        result = RrtResult();
+        bool ok = search(start, goal, result, pool, T0);
+        result.seconds = secondsSince(T0);
+
+        ++stats.plans;
+        stats.solved += ok;
+        stats.seconds += result.seconds;
+        stats.edgeChecks += result.edgeChecks;
+        return ok;
+    }
+
+private:
+    struct Candidate {
+        uint32_t node;
+        float distance;
+        bool free;
+    };
+
+    struct Sample {
+        glm::vec3 point;
+        bool valid;
+        bool reachesGoal;
+        uint32_t parent;
+        std::vector<uint32_t> near;
+        std::vector<Candidate> candidates;
+        size_t edgeChecks;
+    };
+
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    const World* world;
+    std::vector<glm::vec3> obstacleMin;
+    std::vector<glm::vec3> obstacleMax;
+    Bvh obstacles;
+    RrtStats stats;
+
+    KdTree tree;
+    std::vector<uint32_t> parent;
+    std::vector<float> cost;
+    std::vector<uint32_t> firstChild;
+    std::vector<uint32_t> nextSibling;
+    std::vector<uint32_t> goalLinks;     // nodes with a free edge to the goal
+    std::vector<uint32_t> stack;
+    Sample batch[RRT_BATCH_SIZE];
+
+    static double secondsSince(std::chrono::high_resolution_clock::time_point t) {
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t).count();
+    }
+
+    bool inBounds(const glm::vec3& p) const {
+        return glm::all(glm::greaterThanEqual(p, boundsMin)) && glm::all(glm::lessThanEqual(p, boundsMax));
+    }
+
+    bool boxBlocked(const glm::vec3& lo, const glm::vec3& hi) const {
+        bool hit = false;
+        obstacles.forEachOverlap(lo, hi, [&](uint32_t) {
+            hit = true;
+            return false;
+        });
+        return hit || (world && world->overlapsBox(lo, hi));
+    }
+
+    // Slab test of the segment a-b against a box.
+    static bool segmentHitsBox(const glm::vec3& a, const glm::vec3& b, const glm::vec3& lo, const glm::vec3& hi) {
+        glm::vec3 d = b - a;
+        float enter = 0.0f, exit = 1.0f;
+        for (int k = 0; k < 3; ++k) {
+            if (std::abs(d[k]) < 1e-8f) {
+                if (a[k] < lo[k] || a[k] > hi[k]) return false;
+                continue;
+            }
+            float t0 = (lo[k] - a[k]) / d[k], t1 = (hi[k] - a[k]) / d[k];
+            enter = std::max(enter, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+            if (enter > exit) return false;
+        }
+        return true;
+    }
+
+    // Sample `index` from Philox keyed by the seed: the goal with
+    // probability goalBias, otherwise uniform in the bounds or, once a path
+    // of length `best` exists, uniform in the informed ellipsoid with foci
+    // at start and goal. Rejected draws retry on the next counter.
+    glm::vec3 drawSample(uint32_t index, const glm::vec3& start, const glm::vec3& goal, float best) const {
+        const uint32_t key[2] = {config.seed, 0x52525453u};
+        float direct = glm::length(goal - start);
+        bool informed = config.informed && best < 3.4e38f && direct > 1e-6f;
+
+        glm::vec3 axis = informed ? (goal - start) / direct : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 helper = std::abs(axis.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 side = glm::normalize(glm::cross(axis, helper)), up = glm::cross(axis, side);
+        float major = 0.5f * best;
+        float minor = informed ? 0.5f * std::sqrt(std::max(best * best - direct * direct, 0.0f)) : 0.0f;
+
+        glm::vec3 p = goal;
+        for (uint32_t attempt = 0; attempt < RRT_MAX_SAMPLE_ATTEMPTS; ++attempt) {
+            const uint32_t counter[4] = {index, attempt, 0u, 0u};
+            uint32_t bits[4];
+            Philox4x32::generate(counter, key, bits);
+            if (attempt == 0 && philoxUniform(bits[3]) < config.goalBias) return goal;
+
+            glm::vec3 u(philoxUniform(bits[0]), philoxUniform(bits[1]), philoxUniform(bits[2]));
+            if (informed) {
+                glm::vec3 ball = 2.0f * u - 1.0f;
+                if (glm::dot(ball, ball) > 1.0f) continue;
+                p = 0.5f * (start + goal) + axis * (ball.x * major) + side * (ball.y * minor) + up * (ball.z * minor);
+            } else {
+                p = boundsMin + u * (boundsMax - boundsMin);
+            }
+            if (inBounds(p)) return p;
+        }
+        return p;
+    }
+
+    // gamma > 2 (1 + 1/d)^(1/d) (volume / unit-ball volume)^(1/d), d = 3,
+    // where the volume is that of the bounds or of the informed ellipsoid,
+    // whichever is smaller.
+    float nearRadius(size_t nodes, float best, float direct) const {
+        glm::vec3 extent = boundsMax - boundsMin;
+        float volume = extent.x * extent.y * extent.z;
+        if (config.informed && best < 3.4e38f)
+            volume = std::min(volume, 4.18879f * 0.125f * best * (best * best - direct * direct));
+        float gamma = 2.0f * std::cbrt(4.0f / 3.0f) * std::cbrt(volume / 4.18879f);
+        float n = float(std::max<size_t>(nodes, 2));
+        return std::min(config.rewireScale * gamma * std::cbrt(std::log(n) / n), config.stepSize);
+    }
+
+    uint32_t addNode(const glm::vec3& p, uint32_t up, float c) {
+        uint32_t i = tree.insert(p);
+        parent.push_back(up);
+        cost.push_back(c);
+        firstChild.push_back(KD_TREE_NONE);
+        nextSibling.push_back(KD_TREE_NONE);
+        if (up != KD_TREE_NONE) {
+            nextSibling[i] = firstChild[up];
+            firstChild[up] = i;
+        }
+        return i;
+    }
+
+    // Moves `node` under `up` and pushes the cost change down its subtree.
+    void reparent(uint32_t node, uint32_t up, float c) {
+        uint32_t* link = &firstChild[parent[node]];
+        while (*link != node) link = &nextSibling[*link];
+        *link = nextSibling[node];
+        parent[node] = up;
+        nextSibling[node] = firstChild[up];
+        firstChild[up] = node;
+
+        float delta = c - cost[node];
+        cost[node] = c;
+        stack.clear();
+        for (uint32_t child = firstChild[node]; child != KD_TREE_NONE; child = nextSibling[child]) stack.push_back(child);
+        while (!stack.empty()) {
+            uint32_t i = stack.back();
+            stack.pop_back();
+            cost[i] += delta;
+            for (uint32_t child = firstChild[i]; child != KD_TREE_NONE; child = nextSibling[child]) stack.push_back(child);
+        }
+    }
+
+    // Read-only against the tree: steers towards the sample, picks the
+    // cheapest collision-free parent from the near set and checks the
+    // edges that rewiring through the new node would use.
+    void checkSample(Sample& s, const glm::vec3& goal, float radius) const {
+        s.valid = false;
+        s.reachesGoal = false;
+        s.edgeChecks = 0;
+        s.near.clear();
+        s.candidates.clear();
+
+        uint32_t nearest = tree.nearest(s.point);
+        glm::vec3 from = tree.points[nearest], offset = s.point - from;
+        float length = glm::length(offset);
+        if (length < 1e-4f) return;
+        if (length > config.stepSize) s.point = from + offset * (config.stepSize / length);
+        if (!isFree(s.point)) return;
+
+        tree.withinRadius(s.point, radius, s.near);
+        if (std::find(s.near.begin(), s.near.end(), nearest) == s.near.end()) s.near.push_back(nearest);
+        for (uint32_t i : s.near) s.candidates.push_back({i, glm::length(s.point - tree.points[i]), false});
+        std::sort(s.candidates.begin(), s.candidates.end(), [&](const Candidate& x, const Candidate& y) {
+            return cost[x.node] + x.distance < cost[y.node] + y.distance;
+        });
+
+        // Candidates are in order of cost through them, so the first free
+        // edge gives the parent; later ones are checked only if the new
+        // node could shorten their path.
+        s.parent = KD_TREE_NONE;
+        for (Candidate& c : s.candidates) {
+            float through = s.parent == KD_TREE_NONE ? 0.0f : cost[s.parent] + glm::length(s.point - tree.points[s.parent]);
+            if (s.parent != KD_TREE_NONE && through + c.distance >= cost[c.node]) continue;
+            ++s.edgeChecks;
+            c.free = segmentFree(tree.points[c.node], s.point);
+            if (c.free && s.parent == KD_TREE_NONE) s.parent = c.node;
+        }
+        if (s.parent == KD_TREE_NONE) return;
+        s.valid = true;
+
+        if (glm::length(goal - s.point) <= config.stepSize) {
+            ++s.edgeChecks;
+            s.reachesGoal = segmentFree(s.point, goal);
+        }
+    }
+
+    void commitSample(const Sample& s) {
+        if (!s.valid) return;
+        uint32_t up = s.parent;
+        float best = cost[up] + glm::length(s.point - tree.points[up]);
+        for (const Candidate& c : s.candidates)
+            if (c.free && cost[c.node] + c.distance < best) {
+                best = cost[c.node] + c.distance;
+                up = c.node;
+            }
+        uint32_t node = addNode(s.point, up, best);
+        if (s.reachesGoal) goalLinks.push_back(node);
+
+        for (const Candidate& c : s.candidates)
+            if (c.free && c.node != up && best + c.distance < cost[c.node]) reparent(c.node, node, best + c.distance);
+    }
+
+    bool search(const glm::vec3& start, const glm::vec3& goal, RrtResult& result, ThreadPool* pool,
+                std::chrono::high_resolution_clock::time_point T0) {
+        if (!isFree(start) || !isFree(goal)) return false;
+
+        tree.clear();
+        parent.clear();
+        cost.clear();
+        firstChild.clear();
+        nextSibling.clear();
+        goalLinks.clear();
+        tree.reserve(config.maxSamples + 1);
+        addNode(start, KD_TREE_NONE, 0.0f);
+
+        ++result.edgeChecks;
+        if (segmentFree(start, goal)) goalLinks.push_back(0);
+
+        float best = 3.4e38f;
+        uint32_t bestLink = KD_TREE_NONE;
+        auto updateBest = [&]() {
+            for (uint32_t i : goalLinks) {
+                float c = cost[i] + glm::length(goal - tree.points[i]);
+                if (c < best - 1e-4f) {
+                    best = c;
+                    bestLink = i;
+                    result.costOverTime.push_back({secondsSince(T0), result.samples, best});
+                }
+            }
+        };
+        updateBest();
+
+        while (result.samples < config.maxSamples && bestLink != 0) {
+            if (config.timeLimit > 0.0 && secondsSince(T0) >= config.timeLimit) break;
+
+            size_t count = std::min<size_t>(RRT_BATCH_SIZE, config.maxSamples - result.samples);
+            for (size_t k = 0; k < count; ++k)
+                batch[k].point = drawSample(uint32_t(result.samples + k), start, goal, best);
+            float radius = nearRadius(tree.size(), best, glm::length(goal - start));
+
+            auto range = [&](size_t begin, size_t end, unsigned int) {
+                for (size_t k = begin; k < end; ++k) checkSample(batch[k], goal, radius);
+            };
+            if (pool) pool->parallelFor(count, range, 1);
+            else range(0, count, 0);
+
+            for (size_t k = 0; k < count; ++k) {
+                commitSample(batch[k]);
+                result.edgeChecks += batch[k].edgeChecks;
+            }
+            result.samples += count;
+            updateBest();
+        }
+
+        result.nodes = tree.size();
+        if (bestLink == KD_TREE_NONE) return false;
+
+        result.path.push_back(goal);
+        for (uint32_t i = bestLink; i != KD_TREE_NONE; i = parent[i]) result.path.push_back(tree.points[i]);
+        std::reverse(result.path.begin(), result.path.end());
+        result.cost = best;
+        result.found = true;
+        return true;
+    }
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "philox.hpp"
+#include "swarm.hpp"
+
+#ifndef SENSOR_HISTORY
+    #define SENSOR_HISTORY 256
+#endif
+
+#ifndef SENSOR_BATCH
+    #define SENSOR_BATCH 32
+#endif
+
+#define SENSOR_STREAM_IMU  0u
+#define SENSOR_STREAM_BARO 1u
+#define SENSOR_STREAM_GPS  2u
+
+struct SensorConfig {
+    float imuRate = 1000.0f;
+    float baroRate = 50.0f;
+    float gpsRate = 10.0f;
+
+    float accelNoise = 0.5f;
+    float accelBiasWalk = 0.002f;
+    float gyroNoise = 0.01f;
+    float gyroBiasWalk = 0.0001f;
+    float baroNoise = 0.5f;
+    float baroBiasWalk = 0.01f;
+    float gpsPositionNoise = 1.5f;
+    float gpsVelocityNoise = 0.2f;
+
+    float imuLatency = 0.002f;
+    float baroLatency = 0.02f;
+    float gpsLatency = 0.1f;
+
+    uint32_t seed = 1;
+};
+
+struct ImuSample {
+    glm::vec3 accel;
+    glm::vec3 gyro;
+    float time;
+};
+
+struct BaroSample {
+    float altitude;
+    float time;
+};
+
+struct GpsSample {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float time;
+};
+
+// Simulated IMU, barometer and GPS for every drone in a Swarm. Each sensor
+// samples at its own fixed rate (the IMU typically several times per physics
+// step, holding the latest dynamics), adds white noise and a random-walk
+// bias, and publishes a sample only once its latency has elapsed. Noise is
+// drawn from Philox keyed by (seed, drone) and indexed by sample number, so
+// the sequence for a drone is identical however the swarm is split across
+// threads. Disjoint ranges of drones may be updated concurrently.
+class SensorSuite {
+public:
+    SensorConfig config;
+
+    SensorSuite(size_t count, const SensorConfig& _config = SensorConfig())
+        : config(_config)
+    {
+        time.assign(count, 0.0);
+        accelBias.assign(count, glm::vec3(0.0f));
+        gyroBias.assign(count, glm::vec3(0.0f));
+        baroBias.assign(count, 0.0f);
+
+        imuGenerated.assign(count, 0);
+        baroGenerated.assign(count, 0);
+        gpsGenerated.assign(count, 0);
+
+        imuHistory.resize(count * SENSOR_HISTORY);
+        baroHistory.resize(count * SENSOR_HISTORY);
+        gpsHistory.resize(count * SENSOR_HISTORY);
+    }
+
+    size_t size() const { return time.size(); }
+
+    void reset(size_t i) {
+        time[i] = 0.0;
+        accelBias[i] = glm::vec3(0.0f);
+        gyroBias[i] = glm::vec3(0.0f);
+        baroBias[i] = 0.0f;
+        imuGenerated[i] = baroGenerated[i] = gpsGenerated[i] = 0;
+    }
+
+    void update(const Swarm& swarm, float deltaTime) { update(swarm, deltaTime, 0, size()); }
+
+    void update(const Swarm& swarm, float deltaTime, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            time[i] += deltaTime;
+            sampleImu(swarm, i);
+            sampleBaro(swarm, i);
+            sampleGps(swarm, i);
+        }
+    }
+
+    // Samples are numbered from 0 per drone; those below *Available(i) have
+    // passed their latency. Only the last SENSOR_HISTORY remain addressable.
+    uint64_t imuAvailable(size_t i) const { return available(imuGenerated[i], config.imuRate, config.imuLatency, i); }
+    uint64_t baroAvailable(size_t i) const { return available(baroGenerated[i], config.baroRate, config.baroLatency, i); }
+    uint64_t gpsAvailable(size_t i) const { return available(gpsGenerated[i], config.gpsRate, config.gpsLatency, i); }
+
+    const ImuSample& imuSample(size_t i, uint64_t index) const {
+        return imuHistory[i * SENSOR_HISTORY + index % SENSOR_HISTORY];
+    }
+    const BaroSample& baroSample(size_t i, uint64_t index) const {
+        return baroHistory[i * SENSOR_HISTORY + index % SENSOR_HISTORY];
+    }
+    const GpsSample& gpsSample(size_t i, uint64_t index) const {
+        return gpsHistory[i * SENSOR_HISTORY + index % SENSOR_HISTORY];
+    }
+
+private:
+    std::vector<double> time;
+    std::vector<glm::vec3> accelBias;
+    std::vector<glm::vec3> gyroBias;
+    std::vector<float> baroBias;
+
+    std::vector<uint64_t> imuGenerated;
+    std::vector<uint64_t> baroGenerated;
+    std::vector<uint64_t> gpsGenerated;
+
+    std::vector<ImuSample> imuHistory;
+    std::vector<BaroSample> baroHistory;
+    std::vector<GpsSample> gpsHistory;
+
+    uint64_t available(uint64_t generated, float rate, float latency, size_t i) const {
+        double visible = (time[i] - latency) * rate;
+        if (visible < 1.0) return 0;
+        return std::min<uint64_t>(generated, uint64_t(visible));
+    }
+
+    uint64_t due(float rate, size_t i) const {
+        return uint64_t(time[i] * rate);
+    }
+
+    void streamKey(size_t i, uint32_t key[2]) const {
+        key[0] = config.seed;
+        key[1] = uint32_t(i);
+    }
+
+    void sampleImu(const Swarm& swarm, size_t i) {
+        const uint32_t blocksPerSample = 3;
+        float noise[SENSOR_BATCH * blocksPerSample * 4];
+        uint32_t key[2];
+        streamKey(i, key);
+
+        glm::quat inv = glm::conjugate(swarm.rotation[i]);
+        const glm::quat& w = swarm.angularVelocity[i];
+        glm::vec3 specificForce = inv * (swarm.acceleration[i] - swarm.gravityAcceleration());
+        glm::vec3 rate = inv * glm::vec3(w.x, w.y, w.z);
+
+        uint64_t target = due(config.imuRate, i);
+        while (imuGenerated[i] < target) {
+            size_t n = size_t(std::min<uint64_t>(target - imuGenerated[i], SENSOR_BATCH));
+            philoxNormals(key, uint32_t(imuGenerated[i] * blocksPerSample), SENSOR_STREAM_IMU, n * blocksPerSample, noise);
+
+            for (size_t s = 0; s < n; ++s) {
+                const float* e = noise + s * blocksPerSample * 4;
+                accelBias[i] += config.accelBiasWalk * glm::vec3(e[6], e[7], e[8]);
+                gyroBias[i]  += config.gyroBiasWalk  * glm::vec3(e[9], e[10], e[11]);
+
+                uint64_t k = imuGenerated[i]++;
+                ImuSample& out = imuHistory[i * SENSOR_HISTORY + k % SENSOR_HISTORY];
+                out.accel = specificForce + accelBias[i] + config.accelNoise * glm::vec3(e[0], e[1], e[2]);
+                out.gyro  = rate + gyroBias[i] + config.gyroNoise * glm::vec3(e[3], e[4], e[5]);
+                out.time  = float(k + 1) / config.imuRate;
+            }
+        }
+    }
+
+    void sampleBaro(const Swarm& swarm, size_t i) {
+        uint32_t key[2];
+        streamKey(i, key);
+
+        uint64_t target = due(config.baroRate, i);
+        while (baroGenerated[i] < target) {
+            float e[4];
+            uint64_t k = baroGenerated[i]++;
+            philoxNormals(key, uint32_t(k), SENSOR_STREAM_BARO, 1, e);
+
+            baroBias[i] += config.baroBiasWalk * e[1];
+            BaroSample& out = baroHistory[i * SENSOR_HISTORY + k % SENSOR_HISTORY];
+            out.altitude = swarm.position[i].y + baroBias[i] + config.baroNoise * e[0];
+            out.time = float(k + 1) / config.baroRate;
+        }
+    }
+
+    void sampleGps(const Swarm& swarm, size_t i) {
+        uint32_t key[2];
+        streamKey(i, key);
+
+        uint64_t target = due(config.gpsRate, i);
+        while (gpsGenerated[i] < target) {
+            float e[8];
+            uint64_t k = gpsGenerated[i]++;
+            philoxNormals(key, uint32_t(k * 2), SENSOR_STREAM_GPS, 2, e);
+
+            GpsSample& out = gpsHistory[i * SENSOR_HISTORY + k % SENSOR_HISTORY];
+            out.position = swarm.position[i] + config.gpsPositionNoise * glm::vec3(e[0], e[1], e[2]);
+            out.velocity = swarm.velocity[i] + config.gpsVelocityNoise * glm::vec3(e[3], e[4], e[5]);
+            out.time = float(k + 1) / config.gpsRate;
+        }
+    }
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "propeller.hpp"
+#include "airframe.hpp"
+#include "motor.hpp"
+
+#define SWARM_PROPELLER_COUNT 4
+
+#ifndef SWARM_DRONE_HALF_EXTENTS
+    #define SWARM_DRONE_HALF_EXTENTS glm::vec3(8.92198f, 1.39547f, 9.00467f)
+#endif
+
+// Propeller hub offsets and spin directions, matching Drone::initPropellers.
+inline const glm::vec3 SWARM_PROPELLER_OFFSETS[SWARM_PROPELLER_COUNT] = {
+    {-8.48485f, 0.81592f,  8.5198f},
+    { 8.48485f, 0.81592f,  8.5198f},
+    {-6.91386f, 0.7962f,  -8.5424f},
+    { 6.91386f, 0.7962f,  -8.5424f}
+};
+
+inline const unsigned int SWARM_PROPELLER_TYPES[SWARM_PROPELLER_COUNT] = {
+    PROPELLER_TYPE_CW, PROPELLER_TYPE_CCW, PROPELLER_TYPE_CCW, PROPELLER_TYPE_CW
+};
+
+// Headless population of drones. Holds the same rigid-body state as Drone,
+// one array per field, and integrates it with the same equations as
+// Drone::update and Propeller::update but without meshes, colliders or any
+// GL resources, so it can be stepped on worker threads with no context.
+// Airframe parameters are also stored per drone, so a randomised population
+// steps through exactly the same loop as a uniform one.
+class Swarm {
+public:
+    std::vector<glm::vec3> position;
+    std::vector<glm::quat> rotation;
+    std::vector<glm::vec3> velocity;
+    std::vector<glm::quat> angularVelocity;
+    std::vector<glm::vec3> acceleration;
+
+    // Air velocity at each drone, set by the caller (e.g. from a WindField)
+    // before update(); damping acts relative to it as in Drone::update.
+    std::vector<glm::vec3> wind;
+
+    // Fraction of rotor thrust delivered, below 1 in another drone's downwash.
+    std::vector<float> thrustScale;
+
+    // Velocity command from a behaviour layer (e.g. SwarmBehaviour) for the
+    // controller to track; update() does not read it.
+    std::vector<glm::vec3> desiredVelocity;
+
+    // Per rotor: motor command, normalised rotor speed, and the thrust and
+    // reaction torque the motor curve gives at that speed.
+    std::vector<glm::vec4> targetThrust;
+    std::vector<glm::vec4> rotorSpeed;
+    std::vector<glm::vec4> thrust;
+    std::vector<glm::vec4> rotorTorque;
+
+    std::vector<float> mass;
+    std::vector<glm::vec3> inertia;
+    std::vector<float> maxThrust;
+    std::vector<float> spinTorqueScale;
+    std::vector<float> motorResponse;
+    std::vector<float> linearDamping;
+
+    AirframeParams nominal;
+    MotorCurve motorCurve;
+    float gravity;
+    glm::vec3 halfExtents;
+
+    explicit Swarm(size_t count, float _mass = 0.064f, float _gravity = 9.807f,
+                   const glm::vec3& _halfExtents = SWARM_DRONE_HALF_EXTENTS)
+        : nominal(defaultAirframe(_halfExtents, _mass)), motorCurve(DEFAULT_MOTOR_CURVE), gravity(_gravity), halfExtents(_halfExtents)
+    {
+        resize(count);
+    }
+
+    size_t size() const { return position.size(); }
+
+    void resize(size_t count) {
+        position.assign(count, glm::vec3(0.0f));
+        rotation.assign(count, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        velocity.assign(count, glm::vec3(0.0f));
+        angularVelocity.assign(count, glm::quat(glm::vec4(0.0f)));
+        acceleration.assign(count, glm::vec3(0.0f));
+        wind.assign(count, glm::vec3(0.0f));
+        thrustScale.assign(count, 1.0f);
+        desiredVelocity.assign(count, glm::vec3(0.0f));
+        targetThrust.assign(count, glm::vec4(0.0f));
+        rotorSpeed.assign(count, glm::vec4(0.0f));
+        thrust.assign(count, glm::vec4(0.0f));
+        rotorTorque.assign(count, glm::vec4(0.0f));
+
+        mass.assign(count, nominal.mass);
+        inertia.assign(count, nominal.inertia);
+        maxThrust.assign(count, nominal.maxThrust);
+        spinTorqueScale.assign(count, nominal.spinTorqueScale);
+        motorResponse.assign(count, nominal.motorResponse);
+        linearDamping.assign(count, nominal.linearDamping);
+    }
+
+    void reset(size_t i, const glm::vec3& _position = glm::vec3(0.0f),
+               const glm::quat& _rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f)) {
+        position[i] = _position;
+        rotation[i] = _rotation;
+        velocity[i] = glm::vec3(0.0f);
+        angularVelocity[i] = glm::quat(glm::vec4(0.0f));
+        acceleration[i] = glm::vec3(0.0f);
+        targetThrust[i] = glm::vec4(0.0f);
+        rotorSpeed[i] = glm::vec4(0.0f);
+        thrust[i] = glm::vec4(0.0f);
+        rotorTorque[i] = glm::vec4(0.0f);
+        thrustScale[i] = 1.0f;
+        desiredVelocity[i] = glm::vec3(0.0f);
+    }
+
+    void setAirframe(size_t i, const AirframeParams& params) {
+        mass[i] = params.mass;
+        inertia[i] = params.inertia;
+        maxThrust[i] = params.maxThrust;
+        spinTorqueScale[i] = params.spinTorqueScale;
+        motorResponse[i] = params.motorResponse;
+        linearDamping[i] = params.linearDamping;
+    }
+
+    // Draws drone i's airframe for the given episode; the nominal airframe
+    // when the randomisation ranges are all 1.
+    void randomizeAirframe(size_t i, const AirframeRandomization& randomization, uint32_t episode) {
+        setAirframe(i, randomization.sample(nominal, uint32_t(i), episode));
+    }
+
+    // Drone::update scales gravity by 40 to match the mesh-unit world.
+    glm::vec3 gravityAcceleration() const {
+        return glm::vec3(0.0f, -gravity * 40.0f, 0.0f);
+    }
+
+    void setPropellerThrusts(size_t i, const glm::vec4& thrusts) {
+        targetThrust[i] = glm::clamp(thrusts, 0.0f, 1.0f);
+    }
+
+    void update(float deltaTime) { update(deltaTime, 0, size()); }
+
+    void update(float deltaTime, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::quat rot = rotation[i];
+            glm::vec3 up = rot * glm::vec3(0.0f, 1.0f, 0.0f);
+
+            glm::vec3 netForce(0.0f);
+            glm::vec3 netTorque(0.0f);
+
+            for (int p = 0; p < SWARM_PROPELLER_COUNT; ++p) {
+                glm::vec3 relPos = rot * SWARM_PROPELLER_OFFSETS[p];
+                float t = thrust[i][p] * maxThrust[i] * thrustScale[i];
+                glm::vec3 force = t * up;
+
+                netForce += force;
+                netTorque += glm::cross(relPos, force);
+                netTorque.y += (SWARM_PROPELLER_TYPES[p] == PROPELLER_TYPE_CW ? -1.0f : 1.0f) * rotorTorque[i][p] * spinTorqueScale[i];
+            }
+
+            netForce += mass[i] * gravityAcceleration();
+
+            acceleration[i] = netForce / mass[i];
+            velocity[i] += acceleration[i] * deltaTime;
+            velocity[i] = wind[i] + (velocity[i] - wind[i]) * linearDamping[i];
+            position[i] += velocity[i] * deltaTime;
+
+            glm::quat angularAccel = glm::quat(0.0f, netTorque / inertia[i]);
+            angularVelocity[i] += angularAccel * deltaTime;
+            angularVelocity[i] = glm::normalize(angularVelocity[i] * 0.98f);
+
+            glm::quat deltaRot = 0.5f * angularVelocity[i] * rot * deltaTime;
+            rotation[i] = glm::normalize(deltaRot + rot);
+        }
+
+        if (end > begin) {
+            updateMotors(motorCurve, &targetThrust[begin].x, &motorResponse[begin], SWARM_PROPELLER_COUNT,
+                         &rotorSpeed[begin].x, &thrust[begin].x, &rotorTorque[begin].x,
+                         (end - begin) * SWARM_PROPELLER_COUNT, deltaTime);
+        }
+    }
+
+    // Size in bytes of the dynamic state written by saveState.
+    size_t stateSize() const {
+        size_t bytes = 0;
+        forEachStateArray([&](const void*, size_t n) { bytes += n; });
+        return bytes;
+    }
+
+    void saveState(uint8_t* dst) const {
+        forEachStateArray([&](const void* data, size_t n) {
+            std::memcpy(dst, data, n);
+            dst += n;
+        });
+    }
+
+    void loadState(const uint8_t* src) {
+        forEachStateArray([&](void* data, size_t n) {
+            std::memcpy(data, src, n);
+            src += n;
+        });
+    }
+
+    void getBounds(size_t i, glm::vec3& min, glm::vec3& max) const {
+        glm::mat3 R = glm::mat3_cast(rotation[i]);
+        glm::vec3 extent(0.0f);
+        for (int c = 0; c < 3; ++c)
+            extent += glm::abs(R[c]) * halfExtents[c];
+        min = position[i] - extent;
+        max = position[i] + extent;
+    }
+
+private:
+    template <typename F>
+    void forEachStateArray(F f) { visitStateArrays(*this, f); }
+
+    template <typename F>
+    void forEachStateArray(F f) const { visitStateArrays(*this, f); }
+
+    // Calls f(data, bytes) on each state array; data is const when `s` is.
+    template <typename S, typename F>
+    static void visitStateArrays(S& s, F& f) {
+        f(s.position.data(), s.position.size() * sizeof(glm::vec3));
+        f(s.rotation.data(), s.rotation.size() * sizeof(glm::quat));
+        f(s.velocity.data(), s.velocity.size() * sizeof(glm::vec3));
+        f(s.angularVelocity.data(), s.angularVelocity.size() * sizeof(glm::quat));
+        f(s.acceleration.data(), s.acceleration.size() * sizeof(glm::vec3));
+        f(s.wind.data(), s.wind.size() * sizeof(glm::vec3));
+        f(s.thrustScale.data(), s.thrustScale.size() * sizeof(float));
+        f(s.desiredVelocity.data(), s.desiredVelocity.size() * sizeof(glm::vec3));
+        f(s.targetThrust.data(), s.targetThrust.size() * sizeof(glm::vec4));
+        f(s.rotorSpeed.data(), s.rotorSpeed.size() * sizeof(glm::vec4));
+        f(s.thrust.data(), s.thrust.size() * sizeof(glm::vec4));
+        f(s.rotorTorque.data(), s.rotorTorque.size() * sizeof(glm::vec4));
+        f(s.mass.data(), s.mass.size() * sizeof(float));
+        f(s.inertia.data(), s.inertia.size() * sizeof(glm::vec3));
+        f(s.maxThrust.data(), s.maxThrust.size() * sizeof(float));
+        f(s.spinTorqueScale.data(), s.spinTorqueScale.size() * sizeof(float));
+        f(s.motorResponse.data(), s.motorResponse.size() * sizeof(float));
+        f(s.linearDamping.data(), s.linearDamping.size() * sizeof(float));
+    }
+};
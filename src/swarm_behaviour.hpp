@@ -0,0 +1,178 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include "spatial_grid.hpp"
+#include "thread_pool.hpp"
+#include "swarm.hpp"
+
+struct BehaviourConfig {
+    float neighbourRadius = 60.0f;    // alignment and cohesion range
+    float separationRadius = 25.0f;   // closer neighbours are pushed away
+    float separationWeight = 1.5f;
+    float alignmentWeight = 1.0f;
+    float cohesionWeight = 0.5f;
+    float cohesionGain = 1.0f;        // 1/s, towards the neighbour centroid
+    float formationWeight = 1.0f;
+    float formationGain = 2.0f;       // 1/s, towards the formation slot
+    float maxSpeed = 200.0f;
+};
+
+struct BehaviourStats {
+    size_t pairsTested;
+    double seconds;
+};
+
+// Boids-style flocking plus formation keeping for a Swarm. For each drone,
+// the neighbours within `neighbourRadius` give three terms: separation, a
+// push away from anyone inside `separationRadius` that grows linearly to
+// maxSpeed at contact; alignment, their mean velocity; and cohesion, a
+// pull towards their centroid. With a formation set, each drone is also
+// drawn towards its slot (formationCentre + its offset) and carried along
+// at formationVelocity. The weighted sum, clamped to maxSpeed, is written
+// to Swarm::desiredVelocity.
+//
+// Neighbours come from a SpatialGrid rebuilt every call, as in
+// DownwashModel, so the cost is O(N * k) for k drones within the radius and
+// stays linear in N at constant density. Drones are spread over the pool;
+// each writes only its own desiredVelocity entry.
+class SwarmBehaviour {
+public:
+    BehaviourConfig config;
+    glm::vec3 formationCentre;
+    glm::vec3 formationVelocity;
+
+    SwarmBehaviour(const glm::vec3& worldMin, const glm::vec3& worldMax, const BehaviourConfig& _config = BehaviourConfig())
+        : config(_config), formationCentre(0.0f), formationVelocity(0.0f),
+          grid(0.5f * _config.neighbourRadius, worldMin, worldMax), stats{0, 0.0} {}
+
+    const BehaviourStats& getStats() const { return stats; }
+
+    // Slot offset of each drone from formationCentre; an empty list turns
+    // formation keeping off.
+    void setFormation(const std::vector<glm::vec3>& offsets) { formationOffsets = offsets; }
+
+    void apply(Swarm& swarm, ThreadPool* pool = nullptr) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        size_t count = swarm.size();
+
+        agents.resize(count);
+        grid.clear();
+        for (size_t j = 0; j < count; ++j) {
+            grid.insertObstacle(int(j), swarm.position[j]);
+            agents[j].position = swarm.position[j];
+            agents[j].velocity = swarm.velocity[j];
+        }
+
+        unsigned int workers = pool ? pool->size() : 1;
+        pairs.assign(workers, 0);
+
+        auto range = [&](size_t begin, size_t end, unsigned int worker) {
+            size_t tested = 0;
+            for (size_t i = begin; i < end; ++i)
+                swarm.desiredVelocity[i] = desiredAt(i, tested);
+            pairs[worker] += tested;
+        };
+
+        if (pool) pool->parallelFor(count, range, 128);
+        else range(0, count, 0);
+
+        stats.pairsTested = 0;
+        for (size_t p : pairs) stats.pairsTested += p;
+        stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - T0).count();
+    }
+
+private:
+    struct alignas(32) Agent {
+        glm::vec3 position;
+        glm::vec3 velocity;
+    };
+
+    SpatialGrid grid;
+    std::vector<Agent> agents;
+    std::vector<glm::vec3> formationOffsets;
+    std::vector<size_t> pairs;
+    BehaviourStats stats;
+
+    glm::vec3 desiredAt(size_t i, size_t& tested) const {
+        const glm::vec3 p = agents[i].position;
+        const float radius2 = config.neighbourRadius * config.neighbourRadius;
+        const float invSeparation = 1.0f / config.separationRadius;
+        glm::vec3 push(0.0f), velocitySum(0.0f), positionSum(0.0f);
+        float neighbours = 0.0f;
+
+        // Branch-free like DownwashModel::lossAt: candidates outside the
+        // radius (and the drone itself) get zero weight.
+        grid.forEachInBox(p - config.neighbourRadius, p + config.neighbourRadius, [&](int j) {
+            const Agent& a = agents[j];
+            glm::vec3 d = p - a.position;
+            float dist2 = glm::dot(d, d);
+            float inside = size_t(j) != i && dist2 <= radius2 ? 1.0f : 0.0f;
+            float invDist = 1.0f / std::sqrt(std::max(dist2, 1e-6f));
+            float closeness = std::max(1.0f - dist2 * invDist * invSeparation, 0.0f);
+
+            push += d * (inside * closeness * invDist);
+            velocitySum += a.velocity * inside;
+            positionSum += a.position * inside;
+            neighbours += inside;
+            ++tested;
+        });
+
+        glm::vec3 desired = push * (config.separationWeight * config.maxSpeed);
+        if (neighbours > 0.0f) {
+            float invCount = 1.0f / neighbours;
+            desired += velocitySum * (invCount * config.alignmentWeight);
+            desired += (positionSum * invCount - p) * (config.cohesionWeight * config.cohesionGain);
+        }
+        if (i < formationOffsets.size()) {
+            glm::vec3 slot = formationCentre + formationOffsets[i];
+            desired += ((slot - p) * config.formationGain + formationVelocity) * config.formationWeight;
+        }
+
+        float speed2 = glm::dot(desired, desired);
+        if (speed2 > config.maxSpeed * config.maxSpeed)
+            desired *= config.maxSpeed / std::sqrt(speed2);
+        return desired;
+    }
+};
+
+// Runs apply() `steps` times on `count` drones on a jittered lattice at
+// constant density (one per `spacing`^3), each holding a lattice-slot
+// formation, and returns the mean seconds per call; like
+// benchmarkDownwash it should grow linearly in `count`.
+inline double benchmarkBehaviour(size_t count, size_t steps = 30, float spacing = 25.0f, ThreadPool* pool = nullptr,
+                                 double* averageNeighbours = nullptr) {
+    int side = std::max(1, int(std::ceil(std::cbrt(double(count)))));
+    glm::vec3 extent(float(side) * spacing);
+
+    Swarm swarm(count);
+    std::vector<glm::vec3> offsets(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 cell(float(i % side), float((i / side) % side), float(i / (size_t(side) * side)));
+        glm::vec3 jitter(float((i * 7919) % 13) - 6.0f, 0.0f, float((i * 104729) % 11) - 5.0f);
+        swarm.reset(i, (cell + 0.5f) * spacing + jitter);
+        swarm.velocity[i] = glm::vec3(float(i % 7) - 3.0f, 0.0f, float(i % 5) - 2.0f);
+        offsets[i] = (cell + 0.5f) * spacing - 0.5f * extent;
+    }
+
+    SwarmBehaviour behaviour(glm::vec3(-spacing), extent + spacing);
+    behaviour.setFormation(offsets);
+    behaviour.formationCentre = 0.5f * extent;
+    double seconds = 0.0;
+    size_t pairs = 0;
+    for (size_t s = 0; s < steps; ++s) {
+        behaviour.apply(swarm, pool);
+        seconds += behaviour.getStats().seconds;
+        pairs += behaviour.getStats().pairsTested;
+    }
+
+    if (averageNeighbours)
+        *averageNeighbours = double(pairs) / double(steps * count);
+    return seconds / double(steps);
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "spatial_grid.hpp"
+#include "contact_solver.hpp"
+#include "heightfield.hpp"
+#include "world.hpp"
+#include "thread_pool.hpp"
+#include "swarm.hpp"
+
+struct SwarmContactStats {
+    size_t contacts;
+    size_t islands;
+    size_t largestIsland;
+    double broadphaseSeconds;
+    double solveSeconds;
+};
+
+// Collision response for a Swarm against each other and a set of static
+// axis-aligned obstacles (e.g. BoxCollider bounds) and, optionally, a
+// Heightfield terrain and a triangle World. Call after
+// Swarm::update: drone bounds are tested through two SpatialGrids, one
+// holding drone centres and one holding every cell each obstacle covers,
+// and the resulting contacts go to a ContactSolver whose impulses are
+// written back into the swarm's velocities. Penetration is removed over
+// the following steps by the solver's Baumgarte bias.
+class SwarmContacts {
+public:
+    ContactSolver solver;
+
+    SwarmContacts(const glm::vec3& worldMin, const glm::vec3& worldMax, float cellSize = 50.0f,
+                  const ContactConfig& config = ContactConfig())
+        : solver(config), drones(cellSize, worldMin, worldMax), obstacleGrid(cellSize, worldMin, worldMax),
+          terrain(nullptr), world(nullptr), stats{0, 0, 0, 0.0, 0.0} {}
+
+    const SwarmContactStats& getStats() const { return stats; }
+
+    void setObstacles(const std::vector<glm::vec3>& mins, const std::vector<glm::vec3>& maxs) {
+        obstacleMin = mins;
+        obstacleMax = maxs;
+        obstacleGrid.clear();
+        for (size_t k = 0; k < obstacleMin.size(); ++k)
+            obstacleGrid.insertBox(int(k), obstacleMin[k], obstacleMax[k]);
+    }
+
+    // Terrain and world are not owned and must outlive this object; nullptr
+    // for none.
+    void setTerrain(const Heightfield* _terrain) { terrain = _terrain; }
+    void setWorld(const World* _world) { world = _world; }
+
+    void resolve(Swarm& swarm, float deltaTime, ThreadPool* pool = nullptr) {
+        auto T0 = std::chrono::high_resolution_clock::now();
+        size_t count = swarm.size();
+
+        boundsMin.resize(count);
+        boundsMax.resize(count);
+        glm::vec3 reach(0.0f);
+        drones.clear();
+        for (size_t i = 0; i < count; ++i) {
+            swarm.getBounds(i, boundsMin[i], boundsMax[i]);
+            reach = glm::max(reach, boundsMax[i] - swarm.position[i]);
+            drones.insertObstacle(int(i), swarm.position[i]);
+        }
+
+        unsigned int workers = pool ? pool->size() : 1;
+        found.resize(workers);
+        scratch.resize(workers);
+        for (auto& list : found) list.clear();
+
+        // A pair is reported by its lower index only, so each is found once.
+        auto range = [&](size_t begin, size_t end, unsigned int worker) {
+            std::vector<Contact>& out = found[worker];
+            std::vector<int>& candidates = scratch[worker];
+            Contact c;
+            for (size_t i = begin; i < end; ++i) {
+                drones.forEachInBox(boundsMin[i] - reach, boundsMax[i] + reach, [&](int j) {
+                    if (size_t(j) <= i) return;
+                    glm::vec3 motion = (swarm.velocity[i] - swarm.velocity[j]) * deltaTime;
+                    if (!ContactSolver::boxContact(boundsMin[i], boundsMax[i], boundsMin[j], boundsMax[j], c, motion)) return;
+                    c.a = int(i);
+                    c.b = j;
+                    out.push_back(c);
+                });
+
+                obstacleGrid.queryBox(boundsMin[i], boundsMax[i], candidates);
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+                for (int k : candidates) {
+                    if (!ContactSolver::boxContact(boundsMin[i], boundsMax[i], obstacleMin[k], obstacleMax[k], c, swarm.velocity[i] * deltaTime)) continue;
+                    c.a = int(i);
+                    c.b = CONTACT_STATIC;
+                    out.push_back(c);
+                }
+
+                if (terrain && terrain->boxContact(boundsMin[i], boundsMax[i], c)) {
+                    c.a = int(i);
+                    c.b = CONTACT_STATIC;
+                    out.push_back(c);
+                }
+
+                if (world && world->boxContact(boundsMin[i], boundsMax[i], c, swarm.velocity[i] * deltaTime)) {
+                    c.a = int(i);
+                    c.b = CONTACT_STATIC;
+                    out.push_back(c);
+                }
+            }
+        };
+
+        if (pool) pool->parallelFor(count, range, 256);
+        else range(0, count, 0);
+
+        solver.clear();
+        for (const auto& list : found) solver.addContacts(list);
+
+        auto T1 = std::chrono::high_resolution_clock::now();
+        stats.broadphaseSeconds = std::chrono::duration<double>(T1 - T0).count();
+
+        if (solver.getContacts().empty()) {
+            stats.contacts = stats.islands = stats.largestIsland = 0;
+            stats.solveSeconds = 0.0;
+            return;
+        }
+
+        // Swarm keeps angular velocity in the vector part of a quaternion,
+        // which is what its integrator rotates by, so that part is handed to
+        // the solver and written back.
+        solver.bodies.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const glm::quat& w = swarm.angularVelocity[i];
+            solver.bodies[i] = {swarm.position[i], 1.0f / swarm.mass[i], swarm.velocity[i],
+                                glm::vec3(w.x, w.y, w.z), 1.0f / swarm.inertia[i]};
+        }
+
+        solver.solve(deltaTime, pool);
+
+        for (const Contact& c : solver.getContacts()) {
+            for (int i : {c.a, c.b}) {
+                if (i == CONTACT_STATIC) continue;
+                const SolverBody& b = solver.bodies[i];
+                swarm.velocity[i] = b.velocity;
+                glm::quat& w = swarm.angularVelocity[i];
+                w = glm::quat(w.w, b.angularVelocity.x, b.angularVelocity.y, b.angularVelocity.z);
+            }
+        }
+
+        const ContactStats& s = solver.getStats();
+        stats.contacts = s.contacts;
+        stats.islands = s.islands;
+        stats.largestIsland = s.largestIsland;
+        stats.solveSeconds = s.seconds;
+    }
+
+private:
+    SpatialGrid drones;
+    SpatialGrid obstacleGrid;
+    std::vector<glm::vec3> obstacleMin, obstacleMax;
+    const Heightfield* terrain;
+    const World* world;
+    std::vector<glm::vec3> boundsMin, boundsMax;
+    std::vector<std::vector<Contact>> found;
+    std::vector<std::vector<int>> scratch;
+    SwarmContactStats stats;
+};
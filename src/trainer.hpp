@@ -0,0 +1,348 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <limits>
+#include <cmath>
+#include <string>
+
+#include "box_collider.hpp"
+#include "thread_pool.hpp"
+#include "policy.hpp"
+#include "swarm.hpp"
+
+#ifndef TRAINER_EPISODE_BATCH
+    #define TRAINER_EPISODE_BATCH 32
+#endif
+
+// Bumped whenever the checkpoint layout changes, so old files are rejected.
+#define TRAINER_CHECKPOINT_MAGIC 0x32434644u // "DFC2"
+
+struct TrainerConfig {
+    std::vector<int> layerSizes = {POLICY_OBSERVATION_SIZE, 32, 32, POLICY_ACTION_SIZE};
+
+    size_t populationSize = 512;
+    size_t eliteCount = 16;
+    size_t tournamentSize = 4;
+    float mutationRate = 0.05f;
+    float mutationScale = 0.1f;
+
+    size_t episodeSteps = 600;
+    float timeStep = 1.0f / 60.0f;
+
+    glm::vec3 target = glm::vec3(0.0f, 50.0f, 0.0f);
+    glm::vec3 spawnMin = glm::vec3(-25.0f, 0.0f, -25.0f);
+    glm::vec3 spawnMax = glm::vec3(25.0f, 25.0f, 25.0f);
+    glm::vec3 worldMin = glm::vec3(-250.0f);
+    glm::vec3 worldMax = glm::vec3(250.0f);
+    std::vector<std::pair<glm::vec3, glm::vec3>> obstacles;
+
+    float distanceWeight = 1.0f;
+    float energyWeight = 0.1f;
+    float crashPenalty = 100.0f;
+
+    // Each generation flies one airframe drawn from these ranges, shared by
+    // every genome like the spawn point.
+    AirframeRandomization randomization;
+
+    unsigned int seed = 1;
+};
+
+struct GenerationStats {
+    size_t generation;
+    float bestFitness;
+    float meanFitness;
+    double seconds;
+    double episodesPerSecond;
+};
+
+// Genetic algorithm over the flattened weights of a PolicyNetwork. Every
+// generation each genome flies one headless episode; episodes are batched
+// TRAINER_EPISODE_BATCH at a time into a Swarm driven by a per-drone-weight
+// PolicyNetwork, and batches are spread over the thread pool. Fitness
+// penalises distance to the target, energy (integrated thrust) and crashes
+// into obstacles or out of the world bounds.
+class NeuroevolutionTrainer {
+public:
+    NeuroevolutionTrainer(const TrainerConfig& _config, ThreadPool& _pool)
+        : config(_config), pool(_pool), rng(_config.seed), generation(0)
+    {
+        for (unsigned int i = 0; i < pool.size(); ++i) {
+            workers.push_back(std::make_unique<Worker>(config.layerSizes));
+        }
+        genomeSize = workers[0]->policy.parameterCount();
+
+        genomes.resize(config.populationSize);
+        fitness.assign(config.populationSize, 0.0f);
+        for (auto& genome : genomes) {
+            genome.resize(genomeSize);
+            workers[0]->policy.randomize(rng);
+            workers[0]->policy.getParameters(genome.data(), 0);
+        }
+        best = genomes[0];
+        bestFitness = -std::numeric_limits<float>::infinity();
+        eliteSpawn = glm::vec3(0.0f);
+    }
+
+    GenerationStats runGeneration() {
+        auto T0 = std::chrono::high_resolution_clock::now();
+
+        std::uniform_real_distribution<float> ux(config.spawnMin.x, config.spawnMax.x);
+        std::uniform_real_distribution<float> uy(config.spawnMin.y, config.spawnMax.y);
+        std::uniform_real_distribution<float> uz(config.spawnMin.z, config.spawnMax.z);
+        glm::vec3 spawn(ux(rng), uy(rng), uz(rng));
+        AirframeParams airframe = airframeFor(generation);
+
+        pool.parallelFor(genomes.size(), [&](size_t begin, size_t end, unsigned int worker) {
+            for (size_t b = begin; b < end; b += TRAINER_EPISODE_BATCH)
+                evaluateBatch(*workers[worker], b, std::min<size_t>(end, b + TRAINER_EPISODE_BATCH), spawn, airframe);
+        }, TRAINER_EPISODE_BATCH);
+
+        GenerationStats stats;
+        stats.generation = generation;
+        stats.meanFitness = std::accumulate(fitness.begin(), fitness.end(), 0.0f) / float(fitness.size());
+
+        std::vector<size_t> order(genomes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return fitness[a] > fitness[b]; });
+
+        stats.bestFitness = fitness[order[0]];
+        if (stats.bestFitness > bestFitness) {
+            bestFitness = stats.bestFitness;
+            best = genomes[order[0]];
+        }
+
+        breed(order);
+        eliteSpawn = spawn;
+        ++generation;
+
+        auto T1 = std::chrono::high_resolution_clock::now();
+        stats.seconds = std::chrono::duration<double>(T1 - T0).count();
+        stats.episodesPerSecond = double(config.populationSize) / stats.seconds;
+        return stats;
+    }
+
+    const std::vector<float>& getBestGenome() const { return best; }
+    float getBestFitness() const { return bestFitness; }
+    size_t getGenomeSize() const { return genomeSize; }
+    size_t getGeneration() const { return generation; }
+
+    // Writes the best genome so far, then up to `count` elites of the last
+    // generation with the fitness they scored. Breeding keeps the elites at
+    // the front of the population, so these are the only genomes whose
+    // scores are known; the spawn point they flew from is stored so that
+    // the scores can be reproduced.
+    bool saveCheckpoint(const std::string& path, size_t count = 1) const {
+        count = std::min(count, eliteFitness.size());
+
+        std::ofstream file(path, std::ios_base::binary);
+        if (!file) {
+            std::cerr << "Error: Could not write checkpoint '" << path << "'.\n";
+            return false;
+        }
+
+        uint32_t header[4] = {TRAINER_CHECKPOINT_MAGIC, uint32_t(genomeSize), uint32_t(count + 1), uint32_t(generation)};
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(&eliteSpawn), sizeof(glm::vec3));
+        file.write(reinterpret_cast<const char*>(&bestFitness), sizeof(float));
+        file.write(reinterpret_cast<const char*>(best.data()), genomeSize * sizeof(float));
+        for (size_t i = 0; i < count; ++i) {
+            file.write(reinterpret_cast<const char*>(&eliteFitness[i]), sizeof(float));
+            file.write(reinterpret_cast<const char*>(genomes[i].data()), genomeSize * sizeof(float));
+        }
+        return bool(file);
+    }
+
+    // All-or-nothing: a short or mismatched file leaves the trainer as it was.
+    bool loadCheckpoint(const std::string& path) {
+        std::ifstream file(path, std::ios_base::binary);
+        uint32_t header[4];
+        glm::vec3 spawn;
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            header[0] != TRAINER_CHECKPOINT_MAGIC || header[1] != genomeSize || header[2] == 0 ||
+            !file.read(reinterpret_cast<char*>(&spawn), sizeof(glm::vec3))) {
+            std::cerr << "Error: Invalid checkpoint '" << path << "'.\n";
+            return false;
+        }
+
+        // Record 0 is the best genome, then the elites in rank order.
+        size_t kept = std::min<size_t>(header[2], genomes.size() + 1);
+        std::vector<float> fitness(kept);
+        std::vector<std::vector<float>> loaded(kept, std::vector<float>(genomeSize));
+        std::vector<float> skipped(genomeSize);
+        for (uint32_t i = 0; i < header[2]; ++i) {
+            float f;
+            float* genome = i < kept ? loaded[i].data() : skipped.data();
+            file.read(reinterpret_cast<char*>(&f), sizeof(float));
+            file.read(reinterpret_cast<char*>(genome), genomeSize * sizeof(float));
+            if (!file) {
+                std::cerr << "Error: Checkpoint '" << path << "' is truncated.\n";
+                return false;
+            }
+            if (i < kept) fitness[i] = f;
+        }
+
+        eliteSpawn = spawn;
+        best = loaded[0];
+        bestFitness = fitness[0];
+        eliteFitness.assign(fitness.begin() + 1, fitness.end());
+        for (size_t i = 1; i < kept; ++i)
+            genomes[i - 1] = std::move(loaded[i]);
+        generation = header[3];
+        return true;
+    }
+
+    // Round-trip check: reloads `path` into a fresh trainer and re-flies
+    // its first elite from the stored spawn point and the airframe of its
+    // generation; true if it scores the saved fitness.
+    bool verifyCheckpoint(const std::string& path, float tolerance = 1e-4f) const {
+        NeuroevolutionTrainer loaded(config, pool);
+        if (!loaded.loadCheckpoint(path)) return false;
+        if (loaded.eliteFitness.empty() || loaded.generation == 0) {
+            std::cerr << "Error: Checkpoint '" << path << "' holds no scored genomes.\n";
+            return false;
+        }
+
+        float saved = loaded.eliteFitness[0];
+        loaded.evaluateBatch(*loaded.workers[0], 0, 1, loaded.eliteSpawn, loaded.airframeFor(loaded.generation - 1));
+        float replayed = loaded.fitness[0];
+        if (std::abs(replayed - saved) > tolerance * std::max(1.0f, std::abs(saved))) {
+            std::cerr << "Error: Checkpoint '" << path << "' elite scores " << replayed
+                      << " on replay, saved as " << saved << ".\n";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Worker {
+        PolicyNetwork policy;
+        Swarm swarm;
+        std::vector<float> energy;
+        std::vector<unsigned char> crashed;
+
+        explicit Worker(const std::vector<int>& layerSizes)
+            : policy(layerSizes, TRAINER_EPISODE_BATCH, false), swarm(TRAINER_EPISODE_BATCH),
+              energy(TRAINER_EPISODE_BATCH), crashed(TRAINER_EPISODE_BATCH) {}
+    };
+
+    TrainerConfig config;
+    ThreadPool& pool;
+    std::mt19937 rng;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::vector<float>> genomes;
+    std::vector<float> fitness;
+    size_t genomeSize;
+    size_t generation;
+
+    std::vector<float> best;
+    float bestFitness;
+
+    // Scores of genomes[0, eliteFitness.size()), the elites carried over
+    // by the last breed(), and the spawn point they were scored from.
+    std::vector<float> eliteFitness;
+    glm::vec3 eliteSpawn;
+
+    AirframeParams airframeFor(size_t gen) const {
+        return config.randomization.sample(workers[0]->swarm.nominal, 0, uint32_t(gen));
+    }
+
+    bool isCrashed(const Swarm& swarm, size_t i) const {
+        glm::vec3 min, max;
+        swarm.getBounds(i, min, max);
+        if (glm::any(glm::lessThan(min, config.worldMin)) || glm::any(glm::greaterThan(max, config.worldMax)))
+            return true;
+        for (const auto& obstacle : config.obstacles)
+            if (BoxCollider::overlaps(min, max, obstacle.first, obstacle.second))
+                return true;
+        return false;
+    }
+
+    void evaluateBatch(Worker& w, size_t begin, size_t end, const glm::vec3& spawn, const AirframeParams& airframe) {
+        size_t n = end - begin;
+        for (size_t i = 0; i < n; ++i) {
+            w.policy.setParameters(genomes[begin + i].data(), i);
+            w.swarm.reset(i, spawn);
+            w.swarm.setAirframe(i, airframe);
+            w.energy[i] = 0.0f;
+            w.crashed[i] = 0;
+        }
+
+        float* obs = w.policy.observations();
+        size_t stride = w.policy.observationStride();
+
+        for (size_t step = 0; step < config.episodeSteps; ++step) {
+            for (size_t i = 0; i < n; ++i) {
+                packObservation(obs + i * stride, config.target, w.swarm.position[i], w.swarm.rotation[i],
+                                w.swarm.velocity[i], w.swarm.angularVelocity[i]);
+            }
+            w.policy.evaluate(n);
+
+            const float* act = w.policy.actions();
+            for (size_t i = 0; i < n; ++i) {
+                if (w.crashed[i]) continue;
+                const float* a = act + i * stride;
+                w.swarm.setPropellerThrusts(i, glm::vec4(a[0], a[1], a[2], a[3]));
+                w.swarm.update(config.timeStep, i, i + 1);
+
+                glm::vec4 t = w.swarm.thrust[i];
+                w.energy[i] += (t.x + t.y + t.z + t.w) * config.timeStep;
+                w.crashed[i] = isCrashed(w.swarm, i);
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            float distance = glm::length(config.target - w.swarm.position[i]);
+            fitness[begin + i] = -config.distanceWeight * distance
+                                 - config.energyWeight * w.energy[i]
+                                 - (w.crashed[i] ? config.crashPenalty : 0.0f);
+        }
+    }
+
+    size_t tournament(const std::vector<size_t>& order) {
+        std::uniform_int_distribution<size_t> pick(0, order.size() - 1);
+        size_t winner = pick(rng);
+        for (size_t i = 1; i < config.tournamentSize; ++i)
+            winner = std::min(winner, pick(rng));
+        return order[winner];
+    }
+
+    void breed(const std::vector<size_t>& order) {
+        std::vector<std::vector<float>> next;
+        next.reserve(genomes.size());
+
+        size_t elites = std::min(config.eliteCount, genomes.size());
+        eliteFitness.resize(elites);
+        for (size_t i = 0; i < elites; ++i) {
+            next.push_back(genomes[order[i]]);
+            eliteFitness[i] = fitness[order[i]];
+        }
+
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::normal_distribution<float> noise(0.0f, config.mutationScale);
+
+        while (next.size() < genomes.size()) {
+            const auto& a = genomes[tournament(order)];
+            const auto& b = genomes[tournament(order)];
+
+            std::vector<float> child(genomeSize);
+            for (size_t g = 0; g < genomeSize; ++g) {
+                child[g] = unit(rng) < 0.5f ? a[g] : b[g];
+                if (unit(rng) < config.mutationRate)
+                    child[g] += noise(rng);
+            }
+            next.push_back(std::move(child));
+        }
+        genomes.swap(next);
+    }
+};
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <random>
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "box_collider.hpp"
+#include "thread_pool.hpp"
+#include "policy.hpp"
+#include "swarm.hpp"
+
+#define VEC_ENV_MAGIC   0x564e4556u // "VENV"
+#define VEC_ENV_VERSION 1u
+#define VEC_ENV_ALIGN   64
+
+// Fixed header at the start of every environment buffer. Offsets are in bytes
+// from the start of the buffer so a consumer in another process can locate
+// the arrays without sharing pointers. `step` is bumped after every
+// step()/reset() has finished writing, so readers can poll it.
+struct VecEnvHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t observationSize;
+    uint32_t actionSize;
+    uint32_t reserved;
+    uint64_t observationOffset;
+    uint64_t actionOffset;
+    uint64_t rewardOffset;
+    uint64_t doneOffset;
+    uint64_t totalSize;
+    std::atomic<uint64_t> step;
+};
+
+inline size_t vecEnvAlign(size_t n) {
+    return (n + VEC_ENV_ALIGN - 1) / VEC_ENV_ALIGN * VEC_ENV_ALIGN;
+}
+
+inline size_t vecEnvBufferSize(size_t count) {
+    size_t size = vecEnvAlign(sizeof(VecEnvHeader));
+    size += vecEnvAlign(count * POLICY_OBSERVATION_SIZE * sizeof(float));
+    size += vecEnvAlign(count * POLICY_ACTION_SIZE * sizeof(float));
+    size += vecEnvAlign(count * sizeof(float));
+    size += vecEnvAlign(count * sizeof(uint8_t));
+    return size;
+}
+
+// POSIX shared-memory segment that can back a VecEnv. The creating process
+// owns the name and unlinks it on destruction.
+class SharedEnvBuffer {
+public:
+    SharedEnvBuffer(const std::string& _name, size_t _size, bool _create = true)
+        : name(_name), size(_size), create(_create), data(nullptr)
+    {
+#ifndef _WIN32
+        int fd = shm_open(name.c_str(), create ? (O_CREAT | O_RDWR) : O_RDWR, 0600);
+        if (fd < 0) {
+            std::cerr << "Error: shm_open('" << name << "') failed.\n";
+            return;
+        }
+        if (create && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "Error: Could not size shared memory '" << name << "'.\n";
+            close(fd);
+            return;
+        }
+        struct stat info;
+        if (!create && (fstat(fd, &info) != 0 || size_t(info.st_size) < size)) {
+            std::cerr << "Error: Shared memory '" << name << "' is smaller than " << size << " bytes.\n";
+            close(fd);
+            return;
+        }
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (ptr == MAP_FAILED) {
+            std::cerr << "Error: mmap of '" << name << "' failed.\n";
+            return;
+        }
+        data = ptr;
+#else
+        std::cerr << "Error: Shared environment buffers are not supported on this platform.\n";
+#endif
+    }
+
+    ~SharedEnvBuffer() {
+#ifndef _WIN32
+        if (data) munmap(data, size);
+        if (create) shm_unlink(name.c_str());
+#endif
+    }
+
+    SharedEnvBuffer(const SharedEnvBuffer&) = delete;
+    SharedEnvBuffer& operator=(const SharedEnvBuffer&) = delete;
+
+    void* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    std::string name;
+    size_t size;
+    bool create;
+    void* data;
+};
+
+// Flat copy of a VecEnv's dynamic state, see VecEnv::snapshot.
+struct VecEnvSnapshot {
+    std::vector<uint8_t> data;
+};
+
+// Batched reset/step interface over a headless Swarm. All observations,
+// actions, rewards and done flags live in one caller-owned buffer laid out
+// as described by VecEnvHeader; the environment reads actions from and
+// writes results to that buffer in place, never copying it.
+class VecEnv {
+public:
+    glm::vec3 target;
+    glm::vec3 spawnMin, spawnMax;
+    glm::vec3 worldMin, worldMax;
+    std::vector<std::pair<glm::vec3, glm::vec3>> obstacles;
+
+    float timeStep;
+    uint32_t maxEpisodeSteps;
+    float distanceWeight;
+    float crashPenalty;
+
+    // Airframe ranges drawn per drone at every reset. Each drone keeps its
+    // own episode counter, so the draws do not depend on reset order.
+    AirframeRandomization randomization;
+
+    // `buffer` must hold at least vecEnvBufferSize(count) bytes.
+    VecEnv(size_t count, void* buffer, size_t bufferSize, ThreadPool* _pool = nullptr, unsigned int seed = 1)
+        : target(0.0f, 50.0f, 0.0f), spawnMin(-25.0f, 0.0f, -25.0f), spawnMax(25.0f, 25.0f, 25.0f),
+          worldMin(-250.0f), worldMax(250.0f), timeStep(1.0f / 60.0f), maxEpisodeSteps(1000),
+          distanceWeight(0.01f), crashPenalty(10.0f),
+          swarm(count), pool(_pool), episodeSteps(count, 0), episodeCount(count, 0), rng(seed)
+    {
+        if (!buffer || bufferSize < vecEnvBufferSize(count)) {
+            std::cerr << "Error: VecEnv of " << count << " drones needs a buffer of "
+                      << vecEnvBufferSize(count) << " bytes.\n";
+            std::exit(-1);
+        }
+        base = static_cast<uint8_t*>(buffer);
+        header = new (base) VecEnvHeader;
+
+        size_t offset = vecEnvAlign(sizeof(VecEnvHeader));
+        header->magic = VEC_ENV_MAGIC;
+        header->version = VEC_ENV_VERSION;
+        header->count = uint32_t(count);
+        header->observationSize = POLICY_OBSERVATION_SIZE;
+        header->actionSize = POLICY_ACTION_SIZE;
+        header->reserved = 0;
+        header->observationOffset = offset; offset += vecEnvAlign(count * POLICY_OBSERVATION_SIZE * sizeof(float));
+        header->actionOffset = offset;      offset += vecEnvAlign(count * POLICY_ACTION_SIZE * sizeof(float));
+        header->rewardOffset = offset;      offset += vecEnvAlign(count * sizeof(float));
+        header->doneOffset = offset;        offset += vecEnvAlign(count * sizeof(uint8_t));
+        header->totalSize = offset;
+        header->step.store(0);
+
+        std::memset(actions(), 0, count * POLICY_ACTION_SIZE * sizeof(float));
+        reset();
+    }
+
+    size_t size() const { return swarm.size(); }
+
+    float* observations() { return reinterpret_cast<float*>(base + header->observationOffset); }
+    float* actions() { return reinterpret_cast<float*>(base + header->actionOffset); }
+    float* rewards() { return reinterpret_cast<float*>(base + header->rewardOffset); }
+    uint8_t* dones() { return base + header->doneOffset; }
+
+    const Swarm& getSwarm() const { return swarm; }
+
+    // Resets every drone whose mask entry is non-zero, or all drones when
+    // mask is null. Passing dones() resets exactly the finished episodes.
+    void reset(const uint8_t* mask = nullptr) {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        float* obs = observations();
+        float* rew = rewards();
+        uint8_t* done = dones();
+
+        for (size_t i = 0; i < size(); ++i) {
+            if (mask && !mask[i]) continue;
+            glm::vec3 spawn = spawnMin + glm::vec3(unit(rng), unit(rng), unit(rng)) * (spawnMax - spawnMin);
+            swarm.reset(i, spawn);
+            if (randomization.enabled())
+                swarm.randomizeAirframe(i, randomization, episodeCount[i]);
+            ++episodeCount[i];
+            episodeSteps[i] = 0;
+            rew[i] = 0.0f;
+            done[i] = 0;
+            writeObservation(obs, i);
+        }
+        header->step.fetch_add(1, std::memory_order_release);
+    }
+
+    // Applies `actionData` (count x POLICY_ACTION_SIZE thrusts in [0, 1]), or
+    // the actions already written into the buffer when it is null.
+    void step(const float* actionData = nullptr) {
+        const float* act = actionData ? actionData : actions();
+
+        auto range = [&](size_t begin, size_t end, unsigned int) {
+            stepRange(act, begin, end);
+        };
+
+        if (pool) pool->parallelFor(size(), range, 256);
+        else range(0, size(), 0);
+
+        header->step.fetch_add(1, std::memory_order_release);
+    }
+
+    // Copies the full dynamic state (swarm, episode counters, RNG and the
+    // observation/reward/done arrays) into one flat buffer. Restoring it
+    // later is a handful of memcpys, so rollouts can branch from any step.
+    void snapshot(VecEnvSnapshot& snap) const {
+        size_t bufferBytes = header->totalSize - header->observationOffset;
+        snap.data.resize(snapshotSize());
+
+        uint8_t* dst = snap.data.data();
+        swarm.saveState(dst);                                             dst += swarm.stateSize();
+        std::memcpy(dst, episodeSteps.data(), size() * sizeof(uint32_t)); dst += size() * sizeof(uint32_t);
+        std::memcpy(dst, episodeCount.data(), size() * sizeof(uint32_t)); dst += size() * sizeof(uint32_t);
+        std::memcpy(dst, &rng, sizeof(rng));                              dst += sizeof(rng);
+        std::memcpy(dst, base + header->observationOffset, bufferBytes);
+    }
+
+    void restore(const VecEnvSnapshot& snap) {
+        if (snap.data.size() != snapshotSize()) {
+            std::cerr << "Error: Snapshot does not match environment size.\n";
+            return;
+        }
+        size_t bufferBytes = header->totalSize - header->observationOffset;
+
+        const uint8_t* src = snap.data.data();
+        swarm.loadState(src);                                             src += swarm.stateSize();
+        std::memcpy(episodeSteps.data(), src, size() * sizeof(uint32_t)); src += size() * sizeof(uint32_t);
+        std::memcpy(episodeCount.data(), src, size() * sizeof(uint32_t)); src += size() * sizeof(uint32_t);
+        std::memcpy(&rng, src, sizeof(rng));                              src += sizeof(rng);
+        std::memcpy(base + header->observationOffset, src, bufferBytes);
+        header->step.fetch_add(1, std::memory_order_release);
+    }
+
+    size_t snapshotSize() const {
+        return swarm.stateSize() + 2 * size() * sizeof(uint32_t) + sizeof(rng)
+             + (header->totalSize - header->observationOffset);
+    }
+
+private:
+    static_assert(std::is_trivially_copyable<std::mt19937>::value, "snapshot copies the RNG bytewise");
+
+    Swarm swarm;
+    ThreadPool* pool;
+    std::vector<uint32_t> episodeSteps;
+    std::vector<uint32_t> episodeCount;
+    std::mt19937 rng;
+
+    uint8_t* base;
+    VecEnvHeader* header;
+
+    void writeObservation(float* obs, size_t i) {
+        packObservation(obs + i * POLICY_OBSERVATION_SIZE, target, swarm.position[i], swarm.rotation[i],
+                        swarm.velocity[i], swarm.angularVelocity[i]);
+    }
+
+    void stepRange(const float* act, size_t begin, size_t end) {
+        float* obs = observations();
+        float* rew = rewards();
+        uint8_t* done = dones();
+
+        for (size_t i = begin; i < end; ++i) {
+            if (done[i]) {
+                rew[i] = 0.0f;
+                continue;
+            }
+
+            const float* a = act + i * POLICY_ACTION_SIZE;
+            swarm.setPropellerThrusts(i, glm::vec4(a[0], a[1], a[2], a[3]));
+            swarm.update(timeStep, i, i + 1);
+            ++episodeSteps[i];
+
+            glm::vec3 min, max;
+            swarm.getBounds(i, min, max);
+            bool crashed = glm::any(glm::lessThan(min, worldMin)) || glm::any(glm::greaterThan(max, worldMax));
+            for (size_t o = 0; o < obstacles.size() && !crashed; ++o)
+                crashed = BoxCollider::overlaps(min, max, obstacles[o].first, obstacles[o].second);
+
+            rew[i] = -distanceWeight * glm::length(target - swarm.position[i]) - (crashed ? crashPenalty : 0.0f);
+            done[i] = crashed || episodeSteps[i] >= maxEpisodeSteps;
+            writeObservation(obs, i);
+        }
+    }
+};